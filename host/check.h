@@ -0,0 +1,60 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_linux.h"
+
+/*
+ * Host tests run against the simulator, CHECK aborts the test with the
+ * failing expression and survives NDEBUG unlike assert.
+ */
+#define CHECK(expr) do {                                                \
+	if (!(expr)) {                                                  \
+		fprintf(stderr, "%s:%d: check failed: %s\n",            \
+		    __FILE__, __LINE__, #expr);                         \
+		exit(1);                                                \
+	}                                                               \
+} while (0)
+
+/*
+ * Booted simulator on a 10MHz single line link.
+ */
+static inline intptr_t
+check_open(void)
+{
+	struct eve_cfg cfg = { .spi_clk_speed = 10000000 };
+	struct eve_boot boot;
+	intptr_t devc;
+	int64_t now = 0, delay;
+
+	CHECK((devc = eve_init(&cfg)) >= 0);
+
+	delay = eve_boot_init(&boot, devc, now);
+
+	while (delay) {
+		now += delay;
+		delay = eve_boot_step(&boot, now);
+	}
+
+	CHECK(boot.state == EVE_BOOT_DONE);
+	eve_linux_stats_reset(devc);
+
+	return devc;
+}
+
+static inline uint64_t
+check_transactions(intptr_t devc)
+{
+	struct eve_linux_stats st;
+
+	eve_linux_stats(devc, &st);
+	eve_linux_stats_reset(devc);
+
+	return st.transactions;
+}
+
+#endif /* !CHECK_H */
@@ -0,0 +1,254 @@
+/*
+ * Link cost per frame of representative workloads on the simulator: SPI
+ * transactions, bytes on the wire and the time the modelled link takes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_font.h"
+#include "eve_frame.h"
+#include "eve_linux.h"
+#include "eve_scene.h"
+
+#define FRAMES          600
+
+/* Link of the board, see main.c. */
+#define SPI_CLOCK       10000000
+#define SPI_LATENCY_NS  2000
+
+#define LCD_HSIZE       800
+#define LCD_VSIZE       480
+
+/* Refresh period of the timings below with the 60MHz system clock. */
+#define LCD_PERIOD_US   eve_frame_period_us(928, 525, 2, 60000000)
+
+/* 40 labels of 25 characters, 1000 glyphs. */
+#define LABELS          40
+#define LABEL           "Temp 12.5 C, pressure ok."
+
+struct bench {
+	intptr_t devc;
+	struct eve_cp cp;
+	struct eve_dl dl;
+	struct eve_font font;
+	struct eve_scene scene;
+	struct eve_frame frame;
+	int status;
+	int progress;
+};
+
+struct workload {
+	const char *name;
+	int (*setup)(struct bench *bench);
+	void (*frame)(struct bench *bench, uint32_t frame);
+};
+
+static int
+bench_open(struct bench *bench)
+{
+	struct eve_cfg cfg = {
+		.spi_clk_speed = SPI_CLOCK,
+		.latency_ns    = SPI_LATENCY_NS,
+	};
+	struct eve_reg timings[] = {
+		{ EVE_REG_HSIZE,   LCD_HSIZE },
+		{ EVE_REG_HCYCLE,  928       },
+		{ EVE_REG_HOFFSET, 88        },
+		{ EVE_REG_HSYNC1,  48        },
+		{ EVE_REG_VSIZE,   LCD_VSIZE },
+		{ EVE_REG_VCYCLE,  525       },
+		{ EVE_REG_VOFFSET, 32        },
+		{ EVE_REG_VSYNC1,  3         },
+		{ EVE_REG_PCLK,    2         },
+	};
+	struct eve_boot boot;
+	int64_t now = 0, delay;
+
+	if ((bench->devc = eve_init(&cfg)) < 0)
+		return -1;
+
+	delay = eve_boot_init(&boot, bench->devc, now);
+
+	while (delay) {
+		now += delay;
+		delay = eve_boot_step(&boot, now);
+	}
+
+	if (boot.state != EVE_BOOT_DONE)
+		return -1;
+
+	eve_cp_init(&bench->cp, bench->devc);
+
+	return eve_writev(bench->devc, timings, sizeof (timings) / sizeof (timings[0]));
+}
+
+static int
+text_setup(struct bench *bench)
+{
+	return eve_font_rom(&bench->font, bench->devc, 18);
+}
+
+/* Labels drawn by the coprocessor. */
+static void
+text_cp_frame(struct bench *bench, uint32_t frame)
+{
+	struct eve_cp *cp = &bench->cp;
+
+	eve_cp_dlstart(cp);
+	eve_cp_push(cp, EVE_DL_CLEAR_COLOR_RGB(0x00, 0x0f, 0xf0));
+	eve_cp_push(cp, EVE_DL_CLEAR(1, 1, 1));
+
+	for (int i = 0; i < LABELS; ++i)
+		eve_cp_text(cp, i % 2 * 400, i / 2 * 20, 18, 0, LABEL);
+
+	eve_cp_push(cp, EVE_DL_DISPLAY());
+	eve_cp_swap(cp);
+	eve_cp_wait(cp);
+}
+
+/* Same labels as glyph runs in a host built list. */
+static void
+text_glyph_render(void *arg, struct eve_dl *dl, uint32_t frame)
+{
+	struct bench *bench = arg;
+
+	eve_dl_clear_color_rgb(dl, 0x00, 0x0f, 0xf0);
+	eve_dl_clear(dl, EVE_CLEAR_COLOR | EVE_CLEAR_STENCIL | EVE_CLEAR_TAG);
+	eve_font_begin(dl);
+
+	for (int i = 0; i < LABELS; ++i)
+		eve_font_run(dl, &bench->font, i % 2 * 400, i / 2 * 20, LABEL, sizeof (LABEL) - 1);
+
+	eve_font_end(dl);
+	eve_dl_display(dl);
+}
+
+static void
+text_glyph_frame(struct bench *bench, uint32_t frame)
+{
+	eve_dl_init(&bench->dl);
+	text_glyph_render(bench, &bench->dl, frame);
+	eve_dl_swap(bench->devc, &bench->dl);
+}
+
+/* Status bar of main.c, a counter and a gauge changing every frame. */
+static int
+scene_setup(struct bench *bench)
+{
+	struct eve_scene *scene = &bench->scene;
+
+	eve_scene_init(scene);
+	eve_scene_rect(scene, 0, 0, LCD_VSIZE - 24, LCD_HSIZE, 24, 0xff000000, 0);
+	bench->status = eve_scene_text(scene, 1, 8, LCD_VSIZE - 20, 18, 8, 0xffffffff, "");
+	bench->progress = eve_scene_gauge(scene,
+	                                  1,
+	                                  LCD_HSIZE - 208,
+	                                  LCD_VSIZE - 18,
+	                                  200,
+	                                  12,
+	                                  0xff404040,
+	                                  0xff00c000,
+	                                  59);
+
+	return bench->status < 0 || bench->progress < 0 ? -1 : 0;
+}
+
+static void
+scene_render(void *arg, struct eve_dl *dl, uint32_t frame)
+{
+	struct bench *bench = arg;
+	char status[EVE_SCENE_TEXT_MAX];
+
+	snprintf(status, sizeof (status), "frame %08lu", (unsigned long)frame);
+	eve_scene_set_text(&bench->scene, bench->status, status);
+	eve_scene_set_value(&bench->scene, bench->progress, frame % 60);
+
+	eve_dl_clear_color_rgb(dl, 0x00, 0x0f, 0xf0);
+	eve_dl_clear(dl, EVE_CLEAR_COLOR | EVE_CLEAR_STENCIL | EVE_CLEAR_TAG);
+	eve_scene_render(&bench->scene, dl);
+	eve_dl_display(dl);
+}
+
+static void
+scene_frame(struct bench *bench, uint32_t frame)
+{
+	eve_dl_init(&bench->dl);
+	scene_render(bench, &bench->dl, frame);
+	eve_dl_swap(bench->devc, &bench->dl);
+}
+
+/*
+ * Same frame sequences through the scheduler of main.c, lists go out with
+ * eve_dl_swap_delta. One step per refresh, swaps complete instantly on the
+ * simulator.
+ */
+static int
+frame_setup(struct bench *bench, eve_frame_render_t render)
+{
+	return eve_frame_init(&bench->frame, bench->devc, 2, LCD_PERIOD_US, render, bench, 0);
+}
+
+static int
+text_delta_setup(struct bench *bench)
+{
+	return text_setup(bench) < 0 ? -1 : frame_setup(bench, text_glyph_render);
+}
+
+static int
+scene_delta_setup(struct bench *bench)
+{
+	return scene_setup(bench) < 0 ? -1 : frame_setup(bench, scene_render);
+}
+
+static void
+delta_frame(struct bench *bench, uint32_t frame)
+{
+	eve_frame_step(&bench->frame, frame * LCD_PERIOD_US);
+}
+
+static const struct workload workloads[] = {
+	{ "text cmd_text",    text_setup,        text_cp_frame    },
+	{ "text glyph runs",  text_setup,        text_glyph_frame },
+	{ "scene status",     scene_setup,       scene_frame      },
+	{ "text glyph delta", text_delta_setup,  delta_frame      },
+	{ "scene delta",      scene_delta_setup, delta_frame      },
+};
+
+int
+main(void)
+{
+	static struct bench bench;
+	struct eve_linux_stats st;
+
+	printf("%-18s %8s %10s %10s\n", "workload", "xfers", "bytes", "link us");
+
+	for (size_t i = 0; i < sizeof (workloads) / sizeof (workloads[0]); ++i) {
+		const struct workload *w = &workloads[i];
+
+		memset(&bench, 0, sizeof (bench));
+
+		if (bench_open(&bench) < 0 || (w->setup && w->setup(&bench) < 0)) {
+			fprintf(stderr, "%s: setup failed\n", w->name);
+			return 1;
+		}
+
+		eve_linux_stats_reset(bench.devc);
+
+		for (uint32_t frame = 0; frame < FRAMES; ++frame)
+			w->frame(&bench, frame);
+
+		eve_linux_stats(bench.devc, &st);
+		eve_finish(bench.devc);
+
+		printf("%-18s %8.1f %10.1f %10.1f\n",
+		    w->name,
+		    (double)st.transactions / FRAMES,
+		    (double)st.bytes / FRAMES,
+		    (double)st.time_ns / FRAMES / 1000);
+	}
+
+	return 0;
+}
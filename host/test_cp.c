@@ -0,0 +1,70 @@
+/*
+ * Coprocessor FIFO writer: transactions per frame and fault handling.
+ */
+
+#include <string.h>
+
+#include "check.h"
+
+#define FRAMES          100
+
+static void
+frame(struct eve_cp *cp)
+{
+	eve_cp_dlstart(cp);
+	eve_cp_push(cp, EVE_DL_CLEAR_COLOR_RGB(0x00, 0x0f, 0xf0));
+	eve_cp_push(cp, EVE_DL_CLEAR(1, 1, 1));
+
+	for (int i = 0; i < 20; ++i)
+		eve_cp_text(cp, 10, i * 20, 18, 0, "label");
+
+	eve_cp_push(cp, EVE_DL_DISPLAY());
+	eve_cp_swap(cp);
+}
+
+int
+main(void)
+{
+	static uint8_t data[6000];
+	static struct eve_cp cp;
+	intptr_t devc = check_open();
+	size_t words;
+
+	eve_cp_init(&cp, devc);
+
+	/* A frame fitting the staging buffer: REG_CMDB_SPACE then one burst. */
+	for (int i = 0; i < FRAMES; ++i) {
+		frame(&cp);
+		CHECK(cp.len < EVE_CP_BUF_MAX);
+		CHECK(eve_cp_flush(&cp) == 0);
+		CHECK(check_transactions(devc) == 2);
+	}
+
+	/* Larger than the buffer: the same two per buffer full. */
+	CHECK(eve_cp_memwrite(&cp, 0, data, sizeof (data)) == 0);
+	CHECK(eve_cp_flush(&cp) == 0);
+
+	words = 3 + sizeof (data) / 4;
+	CHECK(check_transactions(devc) == 2 * ((words + EVE_CP_BUF_MAX - 1) / EVE_CP_BUF_MAX));
+
+	/* Streamed from caller memory: one burst per FIFO full. */
+	CHECK(eve_cp_push(&cp, EVE_CPC_MEMWRITE) == 0);
+	CHECK(eve_cp_push(&cp, 0) == 0);
+	CHECK(eve_cp_push(&cp, sizeof (data)) == 0);
+	CHECK(eve_cp_stream(&cp, data, sizeof (data)) == 0);
+	CHECK(check_transactions(devc) <= 2 + 2 * (sizeof (data) / (EVE_CP_FIFO_SIZE - 4) + 1));
+
+	CHECK(eve_cp_wait(&cp) == 0);
+
+	/* An unknown command faults the coprocessor, nothing waits forever. */
+	CHECK(eve_cp_push(&cp, 0xffffff7f) == 0);
+	CHECK(eve_cp_wait(&cp) < 0);
+
+	frame(&cp);
+	CHECK(eve_cp_flush(&cp) < 0);
+	CHECK(eve_wait_cmdempty(devc, EVE_WAIT_FOREVER) < 0);
+
+	eve_finish(devc);
+
+	return 0;
+}
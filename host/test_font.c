@@ -0,0 +1,43 @@
+/*
+ * Line breaking with eve_font_fit.
+ */
+
+#include "check.h"
+#include "eve_font.h"
+
+int
+main(void)
+{
+	struct eve_font font = { .height = 16 };
+	size_t next;
+
+	/* Every glyph 8 pixels wide, 'W' 40. */
+	memset(font.widths, 8, sizeof (font.widths));
+	font.widths['W'] = 40;
+
+	/* Cut after the last space that fits, spaces skipped. */
+	CHECK(eve_font_fit(&font, "ab cd ef", 48, &next) == 5);
+	CHECK(next == 6);
+
+	/* Everything fits, up to the line break which is consumed. */
+	CHECK(eve_font_fit(&font, "ab\ncd", 100, &next) == 2);
+	CHECK(next == 3);
+
+	/* A word longer than the line is cut where it overflows. */
+	CHECK(eve_font_fit(&font, "abcdefgh", 32, &next) == 4);
+	CHECK(next == 4);
+
+	/* A first glyph wider than the line still makes progress. */
+	CHECK(eve_font_fit(&font, "Wab", 32, &next) == 1);
+	CHECK(next == 1);
+	CHECK(eve_font_fit(&font, "ab", 0, &next) == 1);
+	CHECK(next == 1);
+
+	/* Nothing to take. */
+	CHECK(eve_font_fit(&font, "", 32, &next) == 0);
+	CHECK(next == 0);
+	CHECK(eve_font_fit(&font, "\nab", 32, &next) == 0);
+	CHECK(next == 1);
+
+	return 0;
+}
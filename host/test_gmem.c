@@ -0,0 +1,94 @@
+/*
+ * RAM_G allocator compaction through CMD_MEMCPY on the simulator.
+ */
+
+#include "check.h"
+#include "eve_gmem.h"
+
+#define BASE            0x10000
+#define SIZE            16384
+
+static void
+fill(intptr_t devc, const struct eve_gmem *gm, int id, uint8_t seed, uint32_t size)
+{
+	uint8_t buf[4096];
+
+	for (uint32_t i = 0; i < size; ++i)
+		buf[i] = seed + i * 7;
+
+	CHECK(eve_write(devc, eve_gmem_address(gm, id), buf, size) == 0);
+}
+
+static void
+check(intptr_t devc, const struct eve_gmem *gm, int id, uint8_t seed, uint32_t size)
+{
+	uint8_t buf[4096];
+
+	CHECK(eve_read(devc, eve_gmem_address(gm, id), buf, size) == 0);
+
+	for (uint32_t i = 0; i < size; ++i)
+		CHECK(buf[i] == (uint8_t)(seed + i * 7));
+}
+
+int
+main(void)
+{
+	static struct eve_gmem gm;
+	static struct eve_cp cp;
+	struct eve_gmem_stats st;
+	intptr_t devc = check_open();
+	int a, b, c, d, e;
+	uint32_t addr;
+
+	eve_cp_init(&cp, devc);
+	eve_gmem_init(&gm, BASE, SIZE);
+
+	CHECK((a = eve_gmem_alloc(&gm, 1000, 4)) >= 0);
+	CHECK((b = eve_gmem_alloc(&gm, 3000, 4)) >= 0);
+	CHECK((c = eve_gmem_alloc(&gm, 4000, 4)) >= 0);
+	CHECK((d = eve_gmem_alloc(&gm, 2000, 4)) >= 0);
+	CHECK((e = eve_gmem_alloc(&gm, 1024, 64)) >= 0);
+
+	fill(devc, &gm, a, 1, 1000);
+	fill(devc, &gm, c, 2, 4000);
+	fill(devc, &gm, e, 3, 1024);
+
+	/* Holes of 3000 and 2000 bytes, 6000 don't fit anywhere. */
+	eve_gmem_free(&gm, b);
+	eve_gmem_free(&gm, d);
+	CHECK(eve_gmem_alloc(&gm, 6000, 4) < 0);
+
+	eve_gmem_stats(&gm, &st);
+	CHECK(st.holes == 3);
+
+	/* c overlaps its own old place, copied in pieces. */
+	CHECK(eve_gmem_compact(&gm, &cp) == 0);
+	CHECK(!gm.stale);
+
+	CHECK(eve_gmem_address(&gm, a) == BASE);
+	CHECK(eve_gmem_address(&gm, c) == BASE + 1000);
+	CHECK(eve_gmem_address(&gm, e) % 64 == 0);
+
+	check(devc, &gm, a, 1, 1000);
+	check(devc, &gm, c, 2, 4000);
+	check(devc, &gm, e, 3, 1024);
+
+	eve_gmem_stats(&gm, &st);
+	CHECK(st.holes == 1);
+	CHECK(eve_gmem_alloc(&gm, 6000, 4) >= 0);
+
+	/* A faulted coprocessor: nothing moves, the content is marked lost. */
+	eve_gmem_free(&gm, a);
+	addr = eve_gmem_address(&gm, c);
+
+	CHECK(eve_cp_push(&cp, 0xffffff7f) == 0);
+	CHECK(eve_cp_wait(&cp) < 0);
+
+	CHECK(eve_gmem_compact(&gm, &cp) < 0);
+	CHECK(gm.stale);
+	CHECK(eve_gmem_address(&gm, c) == addr);
+
+	eve_finish(devc);
+
+	return 0;
+}
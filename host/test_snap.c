@@ -0,0 +1,110 @@
+/*
+ * Screen capture: bands, CRC of a known screen and golden image comparison.
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "eve_snap.h"
+
+#define STAGING         0x10000
+#define WIDTH           100
+#define HEIGHT          50
+#define BAND            7               /* rows, HEIGHT is not a multiple */
+#define PIXEL           0x007e          /* RGB565 of 0x000ff0 */
+
+struct dump {
+	uint32_t bytes;
+	uint8_t data[WIDTH * HEIGHT * 2];
+};
+
+static int
+dump_sink(void *arg, uint32_t offset, const void *data, size_t size)
+{
+	struct dump *dump = arg;
+
+	CHECK(offset == dump->bytes);
+	CHECK(offset + size <= sizeof (dump->data));
+
+	memcpy(&dump->data[offset], data, size);
+	dump->bytes += size;
+
+	return 0;
+}
+
+static int
+golden_read(void *arg, uint32_t offset, void *buf, size_t size)
+{
+	const uint8_t *golden = arg;
+
+	CHECK(offset + size <= WIDTH * HEIGHT * 2);
+	memcpy(buf, &golden[offset], size);
+
+	return 0;
+}
+
+static void
+golden_set(uint8_t *golden, int x, int y)
+{
+	golden[(y * WIDTH + x) * 2] ^= 0xff;
+}
+
+int
+main(void)
+{
+	static uint8_t golden[WIDTH * HEIGHT * 2];
+	static struct dump dump;
+	static struct eve_snap snap;
+	static struct eve_cp cp;
+	struct eve_snap_diff diff;
+	intptr_t devc = check_open();
+
+	eve_cp_init(&cp, devc);
+
+	eve_cp_dlstart(&cp);
+	eve_cp_push(&cp, EVE_DL_CLEAR_COLOR_RGB(0x00, 0x0f, 0xf0));
+	eve_cp_push(&cp, EVE_DL_CLEAR(1, 1, 1));
+	eve_cp_push(&cp, EVE_DL_DISPLAY());
+	eve_cp_swap(&cp);
+	CHECK(eve_cp_wait(&cp) == 0);
+
+	/* Check value of the IEEE 802.3 CRC-32. */
+	CHECK(eve_snap_crc32(0, "123456789", 9) == 0xcbf43926);
+
+	/* Rows must fit in the staging area. */
+	CHECK(eve_snap_init(&snap, &cp, STAGING, WIDTH * 2 - 1, EVE_FORMAT_RGB565, 0, 0, WIDTH, HEIGHT) < 0);
+	CHECK(eve_snap_init(&snap, &cp, STAGING, WIDTH * 2 * BAND, EVE_FORMAT_RGB565, 0, 0, WIDTH, HEIGHT) == 0);
+
+	/* The last band is short, every byte still comes through once. */
+	CHECK(eve_snap_capture(&snap, dump_sink, &dump) == 0);
+	CHECK(snap.bytes == WIDTH * HEIGHT * 2);
+	CHECK(dump.bytes == WIDTH * HEIGHT * 2);
+
+	for (int i = 0; i < WIDTH * HEIGHT; ++i) {
+		golden[i * 2] = PIXEL & 0xff;
+		golden[i * 2 + 1] = PIXEL >> 8;
+	}
+
+	CHECK(memcmp(dump.data, golden, sizeof (golden)) == 0);
+	CHECK(snap.crc == eve_snap_crc32(0, golden, sizeof (golden)));
+
+	/* Identical golden image. */
+	CHECK(eve_snap_compare(&snap, golden_read, golden, &diff) == 0);
+	CHECK(diff.pixels == 0);
+	CHECK(diff.golden_crc == snap.crc);
+
+	/* One pixel at the end of the first band, one in the short last band. */
+	golden_set(golden, 40, BAND - 1);
+	golden_set(golden, 5, HEIGHT - 1);
+
+	CHECK(eve_snap_compare(&snap, golden_read, golden, &diff) == 1);
+	CHECK(diff.pixels == 2);
+	CHECK(diff.x0 == 5 && diff.y0 == BAND - 1);
+	CHECK(diff.x1 == 40 && diff.y1 == HEIGHT - 1);
+	CHECK(diff.golden_crc == eve_snap_crc32(0, golden, sizeof (golden)));
+	CHECK(diff.golden_crc != snap.crc);
+
+	eve_finish(devc);
+
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Display list fragment cache: fragments that can't fit don't evict anything.
+ */
+
+#include "check.h"
+#include "eve_gmem.h"
+#include "eve_snip.h"
+
+int
+main(void)
+{
+	static uint32_t a[64], b[64], large[2048];
+	static struct eve_gmem gm;
+	static struct eve_snip sc;
+	static struct eve_cp cp;
+	intptr_t devc = check_open();
+
+	eve_cp_init(&cp, devc);
+	eve_gmem_init(&gm, 0, 4096);
+	eve_snip_init(&sc, &gm);
+
+	for (size_t i = 0; i < 64; ++i) {
+		a[i] = i;
+		b[i] = ~i;
+	}
+
+	CHECK(eve_snip_put(&sc, &cp, a, 64) >= 0);
+	CHECK(eve_snip_put(&sc, &cp, b, 64) >= 0);
+	CHECK(sc.stats.misses == 2);
+
+	/* 8kB in a 4kB pool. */
+	CHECK(eve_snip_put(&sc, &cp, large, 2048) < 0);
+	CHECK(sc.stats.evictions == 0);
+
+	/*
+	 * Shared pool: another user takes 3400 bytes after both fragments, 184
+	 * are left at the end. 600 bytes don't fit even with the 512 of the
+	 * cache reclaimed.
+	 */
+	CHECK(eve_gmem_alloc(&gm, 3400, 4) >= 0);
+	CHECK(eve_snip_put(&sc, &cp, large, 150) < 0);
+	CHECK(sc.stats.evictions == 0);
+
+	CHECK(eve_snip_put(&sc, &cp, a, 64) >= 0);
+	CHECK(eve_snip_put(&sc, &cp, b, 64) >= 0);
+	CHECK(sc.stats.hits == 2);
+
+	/* 400 bytes need both fragments evicted, oldest first. */
+	CHECK(eve_snip_put(&sc, &cp, large, 100) >= 0);
+	CHECK(sc.stats.evictions == 2);
+
+	CHECK(eve_cp_wait(&cp) == 0);
+	eve_finish(devc);
+
+	return 0;
+}
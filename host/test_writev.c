@@ -0,0 +1,76 @@
+/*
+ * Register writes merged by eve_writev: panel timings of main.c.
+ */
+
+#include "check.h"
+
+static const struct eve_reg timings[] = {
+	{ EVE_REG_HSIZE,    800 },
+	{ EVE_REG_HCYCLE,   928 },
+	{ EVE_REG_HOFFSET,  88  },
+	{ EVE_REG_HSYNC0,   0   },
+	{ EVE_REG_HSYNC1,   48  },
+	{ EVE_REG_VSIZE,    480 },
+	{ EVE_REG_VCYCLE,   525 },
+	{ EVE_REG_VOFFSET,  32  },
+	{ EVE_REG_VSYNC0,   0   },
+	{ EVE_REG_VSYNC1,   3   },
+	{ EVE_REG_PCLK_POL, 1   },
+};
+
+#define NTIMINGS        (sizeof (timings) / sizeof (timings[0]))
+
+int
+main(void)
+{
+	struct eve_reg regs[NTIMINGS];
+	intptr_t devc = check_open();
+	uint64_t single, merged;
+	uint32_t value;
+
+	/* One register at a time, as init_lcd_specs did before eve_writev. */
+	for (size_t i = 0; i < NTIMINGS - 1; ++i)
+		CHECK(eve_write16(devc, timings[i].address, timings[i].value) == 0);
+
+	CHECK(eve_write8(devc, EVE_REG_PCLK_POL, 1) == 0);
+
+	single = check_transactions(devc);
+
+	/* Fresh values so nothing is skipped by the register shadow. */
+	eve_finish(devc);
+	devc = check_open();
+
+	memcpy(regs, timings, sizeof (regs));
+	CHECK(eve_writev(devc, regs, NTIMINGS) == 0);
+
+	merged = check_transactions(devc);
+
+	printf("panel timings: %llu transactions, %llu with eve_writev\n",
+	    (unsigned long long)single, (unsigned long long)merged);
+
+	/* HCYCLE to VSYNC1 in one burst, PCLK_POL in a second one. */
+	CHECK(single >= NTIMINGS);
+	CHECK(merged >= 1 && merged <= 2);
+
+	for (size_t i = 0; i < NTIMINGS; ++i) {
+		CHECK(eve_read32(devc, timings[i].address, &value) == 0);
+		CHECK(value == timings[i].value);
+	}
+
+	/* A duplicate address fails before anything is written. */
+	eve_shadow_invalidate(devc);
+	check_transactions(devc);
+
+	memcpy(regs, timings, sizeof (regs));
+	regs[0].value = 1024;
+	regs[NTIMINGS - 1] = regs[0];
+	CHECK(eve_writev(devc, regs, NTIMINGS) < 0);
+	CHECK(check_transactions(devc) == 0);
+
+	CHECK(eve_read32(devc, EVE_REG_HSIZE, &value) == 0);
+	CHECK(value == 800);
+
+	eve_finish(devc);
+
+	return 0;
+}
@@ -0,0 +1,1288 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eve.h"
+
+/*
+ * REG_CMD_READ is set to this value when the coprocessor encountered a fault,
+ * it will never consume the FIFO again until it is reset.
+ */
+#define CP_FAULT        0xfff
+
+/*
+ * Maximum free space reported by REG_CMDB_SPACE when the FIFO is empty.
+ */
+#define CP_SPACE_MAX    (EVE_CP_FIFO_SIZE - 4)
+
+/*
+ * Number of registers merged in a single eve_writev burst, longer runs are
+ * split.
+ */
+#define REGV_MAX        32
+
+#define EVE(devc)       ((struct eve *)(devc))
+
+/*
+ * Shadow policy: registers the device never changes on its own, with the
+ * number of significant bytes of their word. Registers the
+ * platform writes itself (REG_INT_MASK, REG_INT_EN, REG_SPI_WIDTH) are left
+ * out as well as those the coprocessor changes (REG_ROTATE, REG_GPIOX,
+ * REG_TOUCH_TRANSFORM_*).
+ */
+static const struct {
+	uint32_t address;
+	uint8_t size;
+} shadow_regs[EVE_SHADOW_REGS] = {
+	{ EVE_REG_FREQUENCY,       4 },
+	{ EVE_REG_HCYCLE,          2 },
+	{ EVE_REG_HOFFSET,         2 },
+	{ EVE_REG_HSIZE,           2 },
+	{ EVE_REG_HSYNC0,          2 },
+	{ EVE_REG_HSYNC1,          2 },
+	{ EVE_REG_VCYCLE,          2 },
+	{ EVE_REG_VOFFSET,         2 },
+	{ EVE_REG_VSIZE,           2 },
+	{ EVE_REG_VSYNC0,          2 },
+	{ EVE_REG_VSYNC1,          2 },
+	{ EVE_REG_OUTBITS,         2 },
+	{ EVE_REG_DITHER,          1 },
+	{ EVE_REG_SWIZZLE,         1 },
+	{ EVE_REG_CSPREAD,         1 },
+	{ EVE_REG_PCLK_POL,        1 },
+	{ EVE_REG_PCLK,            1 },
+	{ EVE_REG_VOL_PB,          1 },
+	{ EVE_REG_VOL_SOUND,       1 },
+	{ EVE_REG_GPIO_DIR,        1 },
+	{ EVE_REG_GPIO,            1 },
+	{ EVE_REG_PWM_HZ,          2 },
+	{ EVE_REG_PWM_DUTY,        1 },
+	{ EVE_REG_TOUCH_MODE,      1 },
+	{ EVE_REG_CTOUCH_EXTENDED, 1 },
+	{ EVE_REG_TOUCH_CONFIG,    2 },
+};
+
+_Static_assert(EVE_SHADOW_REGS <= 32, "shadow_valid holds one bit per register");
+
+#define SHADOW_START    EVE_REG_FREQUENCY
+#define SHADOW_END      (EVE_REG_TOUCH_CONFIG + 4)
+
+/*
+ * Bytes of the word of register i overlapping [address, address + size),
+ * those past its size are reserved: ignored when written and read as zero.
+ */
+struct overlap {
+	size_t data;                    /* offset in the transferred data */
+	size_t reg;                     /* offset in the register */
+	size_t len;
+};
+
+static int
+shadow_overlaps(uint32_t address, size_t size)
+{
+	return address < SHADOW_END && address + size > SHADOW_START;
+}
+
+static int
+shadow_overlap(size_t i, uint32_t address, size_t size, struct overlap *ov)
+{
+	uint32_t start = shadow_regs[i].address;
+	uint32_t end = start + 4;
+
+	start = start > address ? start : address;
+	end = end < address + size ? end : address + size;
+
+	if (start >= end)
+		return 0;
+
+	ov->data = start - address;
+	ov->reg = start - shadow_regs[i].address;
+	ov->len = end - start;
+
+	return 1;
+}
+
+/* Significant bytes of an overlap. */
+static size_t
+shadow_len(size_t i, const struct overlap *ov)
+{
+	if (ov->reg >= shadow_regs[i].size)
+		return 0;
+
+	return ov->reg + ov->len > shadow_regs[i].size ? shadow_regs[i].size - ov->reg : ov->len;
+}
+
+static void
+shadow_lock(struct eve *eve)
+{
+	if (eve->ops->lock)
+		eve->ops->lock(eve);
+}
+
+static void
+shadow_unlock(struct eve *eve)
+{
+	if (eve->ops->unlock)
+		eve->ops->unlock(eve);
+}
+
+/*
+ * Returns 1 if every byte written is shadowed with the same value.
+ */
+static int
+shadow_match(struct eve *eve, uint32_t address, const uint8_t *data, size_t size)
+{
+	struct overlap ov;
+	size_t covered = 0;
+
+	for (size_t i = 0; i < EVE_SHADOW_REGS; ++i) {
+		if (!shadow_overlap(i, address, size, &ov))
+			continue;
+		if (!(eve->shadow_valid & (1U << i)))
+			return 0;
+		if (memcmp(&eve->shadow[i][ov.reg], data + ov.data, shadow_len(i, &ov)) != 0)
+			return 0;
+
+		covered += ov.len;
+	}
+
+	return covered == size;
+}
+
+/*
+ * Update registers from transferred data, those only partially known stay
+ * invalid.
+ */
+static void
+shadow_store(struct eve *eve, uint32_t address, const uint8_t *data, size_t size)
+{
+	struct overlap ov;
+
+	for (size_t i = 0; i < EVE_SHADOW_REGS; ++i) {
+		if (!shadow_overlap(i, address, size, &ov))
+			continue;
+		if (!(eve->shadow_valid & (1U << i)) &&
+		    (ov.reg > 0 || ov.len < shadow_regs[i].size))
+			continue;
+
+		memcpy(&eve->shadow[i][ov.reg], data + ov.data, shadow_len(i, &ov));
+		eve->shadow_valid |= 1U << i;
+	}
+}
+
+static void
+shadow_forget(struct eve *eve, uint32_t address, size_t size)
+{
+	struct overlap ov;
+
+	for (size_t i = 0; i < EVE_SHADOW_REGS; ++i)
+		if (shadow_overlap(i, address, size, &ov))
+			eve->shadow_valid &= ~(1U << i);
+}
+
+/*
+ * Returns 1 if the read was served, 0 if it only spans shadowed registers
+ * but some are unknown, -1 if it spans anything else.
+ */
+static int
+shadow_load(struct eve *eve, uint32_t address, uint8_t *data, size_t size)
+{
+	struct overlap ov;
+	size_t covered = 0;
+	int valid = 1;
+
+	for (size_t i = 0; i < EVE_SHADOW_REGS; ++i) {
+		if (!shadow_overlap(i, address, size, &ov))
+			continue;
+		if (!(eve->shadow_valid & (1U << i)))
+			valid = 0;
+		else
+			memcpy(data + ov.data, &eve->shadow[i][ov.reg], ov.len);
+
+		covered += ov.len;
+	}
+
+	if (covered != size)
+		return -1;
+
+	return valid;
+}
+
+static int
+dev_read(struct eve *eve, uint32_t address, void *data, size_t size)
+{
+	int rc;
+
+	if (!shadow_overlaps(address, size))
+		return eve->ops->read(eve, address, data, size);
+
+	shadow_lock(eve);
+
+	switch (shadow_load(eve, address, data, size)) {
+	case 1:
+		eve->shadow_stats.hits++;
+		rc = 0;
+		break;
+	case 0:
+		eve->shadow_stats.misses++;
+		/* fallthrough */
+	default:
+		if ((rc = eve->ops->read(eve, address, data, size)) == 0)
+			shadow_store(eve, address, data, size);
+		break;
+	}
+
+	shadow_unlock(eve);
+
+	return rc;
+}
+
+static int
+dev_write(struct eve *eve, uint32_t address, const void *data, size_t size)
+{
+	int rc;
+
+	if (!shadow_overlaps(address, size))
+		return eve->ops->write(eve, address, data, size);
+
+	shadow_lock(eve);
+
+	if (shadow_match(eve, address, data, size)) {
+		eve->shadow_stats.elided++;
+		rc = 0;
+	} else if ((rc = eve->ops->write(eve, address, data, size)) < 0)
+		shadow_forget(eve, address, size);
+	else if (address <= EVE_REG_CPURESET && address + size > EVE_REG_CPURESET)
+		eve->shadow_valid = 0;
+	else
+		shadow_store(eve, address, data, size);
+
+	shadow_unlock(eve);
+
+	return rc;
+}
+
+static int
+reg_cmp(const void *v1, const void *v2)
+{
+	const struct eve_reg *r1 = v1, *r2 = v2;
+
+	return r1->address < r2->address ? -1 : r1->address > r2->address;
+}
+
+/*
+ * Deadline and polling interval of a wait.
+ */
+struct wait {
+	intptr_t devc;
+	int64_t deadline;               /* INT64_MAX to wait forever */
+	int64_t backoff;
+};
+
+static void
+wait_init(struct wait *wait, intptr_t devc, uint32_t timeout_ms)
+{
+	wait->devc = devc;
+	wait->backoff = EVE_WAIT_POLL_MIN_US;
+
+	if (timeout_ms == EVE_WAIT_FOREVER)
+		wait->deadline = INT64_MAX;
+	else
+		wait->deadline = EVE(devc)->ops->time(EVE(devc)) + timeout_ms * 1000LL;
+}
+
+/*
+ * Wait for any interrupt of mask, or sleep for the polling interval if it's
+ * 0 or there is no interrupt line. Returns -1 once the deadline passed.
+ */
+static int
+wait_event(struct wait *wait, uint8_t mask)
+{
+	struct eve *eve = EVE(wait->devc);
+	int64_t left = INT64_MAX;
+	int rc = -1;
+
+	if (wait->deadline != INT64_MAX) {
+		left = wait->deadline - eve->ops->time(eve);
+
+		if (left <= 0)
+			return -1;
+	}
+
+	if (mask)
+		rc = eve_irq_wait(wait->devc,
+		                  mask,
+		                  left == INT64_MAX ? EVE_WAIT_FOREVER : (uint32_t)((left + 999) / 1000));
+
+	/* Interrupt fired, or the timeout is over and checked next time. */
+	if (rc >= 0)
+		return 0;
+
+	eve->ops->sleep(eve, left < wait->backoff ? left : wait->backoff);
+
+	if (wait->backoff < EVE_WAIT_POLL_MAX_US)
+		wait->backoff *= 2;
+
+	return 0;
+}
+
+/*
+ * Free space in the FIFO, -1 if the coprocessor faulted.
+ */
+static int
+cp_space(intptr_t devc, uint16_t *space)
+{
+	uint16_t rd;
+
+	if (eve_read16(devc, EVE_REG_CMDB_SPACE, space) < 0)
+		return -1;
+
+	/* Derived from REG_CMD_READ, a fault leaves it unaligned. */
+	if (*space & 0x3)
+		return -1;
+
+	*space &= 0xffc;
+
+	/* Coprocessor may have stopped, don't wait forever. */
+	if (*space == 0) {
+		if (eve_read16(devc, EVE_REG_CMD_READ, &rd) < 0)
+			return -1;
+		if ((rd & 0xfff) == CP_FAULT)
+			return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Write size bytes into the FIFO in bursts as large as its free space,
+ * backing off while it is full.
+ *
+ * The lock is held throughout so that commands of other tasks don't get
+ * interleaved. The interrupt task needs it to read REG_INT_FLAGS, waiting on
+ * EVE_IRQ_CMDEMPTY here would deadlock: the FIFO is polled only.
+ */
+static int
+cp_write(intptr_t devc, const void *buf, size_t size)
+{
+	const uint8_t *data = buf;
+	struct wait wait;
+	uint16_t space;
+	size_t n;
+	int rc = 0;
+
+	wait_init(&wait, devc, EVE_WAIT_FOREVER);
+	shadow_lock(EVE(devc));
+
+	while (size) {
+		if ((rc = cp_space(devc, &space)) < 0)
+			break;
+		if (space == 0) {
+			wait_event(&wait, 0);
+			continue;
+		}
+
+		wait.backoff = EVE_WAIT_POLL_MIN_US;
+
+		n = size < space ? size : space;
+
+		if ((rc = eve_write(devc, EVE_REG_CMDB_WRITE, data, n)) < 0)
+			break;
+
+		data += n;
+		size -= n;
+	}
+
+	shadow_unlock(EVE(devc));
+
+	return rc;
+}
+
+static int64_t
+boot_enter(struct eve_boot *boot, enum eve_boot_state state, int64_t now_us)
+{
+	boot->state = state;
+	boot->stamps[state] = now_us - boot->start;
+	boot->deadline = now_us + EVE_BOOT_TIMEOUT_US;
+	boot->backoff = EVE_BOOT_POLL_MIN_US;
+
+	switch (state) {
+	case EVE_BOOT_POWER_OFF:
+		eve_power(boot->devc, 0);
+		return EVE_BOOT_PD_LOW_US;
+	case EVE_BOOT_POWER_ON:
+		eve_power(boot->devc, 1);
+		return EVE_BOOT_PD_HIGH_US;
+	case EVE_BOOT_DONE:
+	case EVE_BOOT_FAILED:
+		return 0;
+	default:
+		return EVE_BOOT_POLL_MIN_US;
+	}
+}
+
+/*
+ * Wait a bit more before polling again, or power cycle the device once the
+ * current state took too long.
+ */
+static int64_t
+boot_poll(struct eve_boot *boot, int64_t now_us)
+{
+	int64_t delay = boot->backoff;
+
+	if (now_us >= boot->deadline) {
+		if (++boot->retries > EVE_BOOT_RETRIES)
+			return boot_enter(boot, EVE_BOOT_FAILED, now_us);
+
+		return boot_enter(boot, EVE_BOOT_POWER_OFF, now_us);
+	}
+
+	if (boot->backoff < EVE_BOOT_POLL_MAX_US)
+		boot->backoff *= 2;
+
+	return delay;
+}
+
+int
+eve_power(intptr_t devc, int enable)
+{
+	int rc;
+
+	shadow_lock(EVE(devc));
+	rc = EVE(devc)->ops->power(EVE(devc), enable);
+	EVE(devc)->shadow_valid = 0;
+	shadow_unlock(EVE(devc));
+
+	return rc;
+}
+
+int
+eve_set_width(intptr_t devc, int width)
+{
+	if (!EVE(devc)->ops->set_width)
+		return width == 1 ? 0 : -1;
+
+	return EVE(devc)->ops->set_width(EVE(devc), width);
+}
+
+int
+eve_irq_enable(intptr_t devc, uint8_t mask)
+{
+	if (!EVE(devc)->ops->irq_enable)
+		return -1;
+
+	return EVE(devc)->ops->irq_enable(EVE(devc), mask);
+}
+
+int
+eve_irq_wait(intptr_t devc, uint8_t mask, uint32_t timeout_ms)
+{
+	if (!EVE(devc)->ops->irq_wait)
+		return -1;
+
+	return EVE(devc)->ops->irq_wait(EVE(devc), mask, timeout_ms);
+}
+
+int
+eve_cmd(intptr_t devc, uint8_t cmd, uint8_t param)
+{
+	int rc;
+
+	shadow_lock(EVE(devc));
+	rc = EVE(devc)->ops->cmd(EVE(devc), cmd, param);
+	EVE(devc)->shadow_valid = 0;
+	shadow_unlock(EVE(devc));
+
+	return rc;
+}
+
+int
+eve_read8(intptr_t devc, uint32_t address, uint8_t *value)
+{
+	assert(value);
+
+	return dev_read(EVE(devc), address, value, 1);
+}
+
+int
+eve_read16(intptr_t devc, uint32_t address, uint16_t *value)
+{
+	assert(value);
+
+	return dev_read(EVE(devc), address, value, 2);
+}
+
+int
+eve_read32(intptr_t devc, uint32_t address, uint32_t *value)
+{
+	assert(value);
+
+	return dev_read(EVE(devc), address, value, 4);
+}
+
+int
+eve_write8(intptr_t devc, uint32_t address, uint8_t value)
+{
+	return dev_write(EVE(devc), address, &value, 1);
+}
+
+int
+eve_write16(intptr_t devc, uint32_t address, uint16_t value)
+{
+	return dev_write(EVE(devc), address, &value, 2);
+}
+
+int
+eve_write32(intptr_t devc, uint32_t address, uint32_t value)
+{
+	return dev_write(EVE(devc), address, &value, 4);
+}
+
+int
+eve_read(intptr_t devc, uint32_t address, void *data, size_t size)
+{
+	assert(data);
+
+	return dev_read(EVE(devc), address, data, size);
+}
+
+int
+eve_write(intptr_t devc, uint32_t address, const void *data, size_t size)
+{
+	assert(data);
+
+	return dev_write(EVE(devc), address, data, size);
+}
+
+int
+eve_write_async(intptr_t devc,
+                uint32_t address,
+                const void *data,
+                size_t size,
+                eve_async_cb_t cb,
+                void *arg)
+{
+	assert(data);
+
+	int rc;
+
+	if (EVE(devc)->ops->write_async) {
+		/* Values land later, simply forget them. */
+		if (shadow_overlaps(address, size)) {
+			shadow_lock(EVE(devc));
+			shadow_forget(EVE(devc), address, size);
+			shadow_unlock(EVE(devc));
+		}
+
+		return EVE(devc)->ops->write_async(EVE(devc), address, data, size, cb, arg);
+	}
+
+	rc = dev_write(EVE(devc), address, data, size);
+
+	if (cb)
+		cb(arg, rc);
+
+	return rc;
+}
+
+int
+eve_async_poll(intptr_t devc)
+{
+	if (!EVE(devc)->ops->async_poll)
+		return 0;
+
+	return EVE(devc)->ops->async_poll(EVE(devc));
+}
+
+int
+eve_async_wait(intptr_t devc)
+{
+	if (!EVE(devc)->ops->async_wait)
+		return 0;
+
+	return EVE(devc)->ops->async_wait(EVE(devc));
+}
+
+void
+eve_lock(intptr_t devc)
+{
+	shadow_lock(EVE(devc));
+}
+
+void
+eve_unlock(intptr_t devc)
+{
+	shadow_unlock(EVE(devc));
+}
+
+void
+eve_shadow_invalidate(intptr_t devc)
+{
+	shadow_lock(EVE(devc));
+	EVE(devc)->shadow_valid = 0;
+	shadow_unlock(EVE(devc));
+}
+
+void
+eve_shadow_stats(intptr_t devc, struct eve_shadow_stats *stats)
+{
+	assert(stats);
+
+	shadow_lock(EVE(devc));
+	*stats = EVE(devc)->shadow_stats;
+	shadow_unlock(EVE(devc));
+}
+
+void
+eve_shadow_stats_reset(intptr_t devc)
+{
+	shadow_lock(EVE(devc));
+	memset(&EVE(devc)->shadow_stats, 0, sizeof (EVE(devc)->shadow_stats));
+	shadow_unlock(EVE(devc));
+}
+
+int64_t
+eve_boot_init(struct eve_boot *boot, intptr_t devc, int64_t now_us)
+{
+	assert(boot);
+
+	memset(boot, 0, sizeof (*boot));
+	boot->devc = devc;
+	boot->start = now_us;
+
+	return boot_enter(boot, EVE_BOOT_POWER_OFF, now_us);
+}
+
+int64_t
+eve_boot_step(struct eve_boot *boot, int64_t now_us)
+{
+	assert(boot);
+
+	uint8_t id;
+	uint16_t status;
+
+	switch (boot->state) {
+	case EVE_BOOT_POWER_OFF:
+		return boot_enter(boot, EVE_BOOT_POWER_ON, now_us);
+	case EVE_BOOT_POWER_ON:
+		eve_cmd(boot->devc, EVE_CMD_RST_PULSE, 0);
+		eve_cmd(boot->devc, EVE_CMD_ACTIVE, 0);
+		return boot_enter(boot, EVE_BOOT_WAIT_ID, now_us);
+	case EVE_BOOT_WAIT_ID:
+		if (eve_read8(boot->devc, EVE_REG_ID, &id) == 0 && id == EVE_ID)
+			return boot_enter(boot, EVE_BOOT_WAIT_RESET, now_us);
+
+		return boot_poll(boot, now_us);
+	case EVE_BOOT_WAIT_RESET:
+		if (eve_read16(boot->devc, EVE_REG_CPURESET, &status) == 0 && status == 0)
+			return boot_enter(boot, EVE_BOOT_DONE, now_us);
+
+		return boot_poll(boot, now_us);
+	default:
+		return 0;
+	}
+}
+
+int
+eve_writev(intptr_t devc, struct eve_reg *regs, size_t n)
+{
+	assert(regs || n == 0);
+
+	uint32_t run[REGV_MAX], start = 0;
+	size_t len = 0;
+
+	qsort(regs, n, sizeof (*regs), reg_cmp);
+
+	/* Nothing is written if a register is given twice. */
+	for (size_t i = 1; i < n; ++i) {
+		if (regs[i].address == regs[i - 1].address)
+			return -1;
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		assert((regs[i].address & 0x3) == 0);
+
+		/* Flush the current run if this register isn't adjacent. */
+		if (len && (len == REGV_MAX || regs[i].address != start + len * 4)) {
+			if (eve_write(devc, start, run, len * 4) < 0)
+				return -1;
+
+			len = 0;
+		}
+
+		if (len == 0)
+			start = regs[i].address;
+
+		run[len++] = regs[i].value;
+	}
+
+	return len ? eve_write(devc, start, run, len * 4) : 0;
+}
+
+int
+eve_readv(intptr_t devc, uint32_t address, uint32_t *values, size_t n)
+{
+	assert(values || n == 0);
+	assert((address & 0x3) == 0);
+
+	return eve_read(devc, address, values, n * 4);
+}
+
+int
+eve_wait_swap(intptr_t devc, uint32_t timeout_ms)
+{
+	struct wait wait;
+	uint8_t swap;
+
+	wait_init(&wait, devc, timeout_ms);
+
+	for (;;) {
+		if (eve_read8(devc, EVE_REG_DLSWAP, &swap) < 0)
+			return -1;
+		if (swap == EVE_DLSWAP_DONE)
+			return 0;
+
+		/* Interrupt may be stale, always re-check the register. */
+		if (wait_event(&wait, EVE_IRQ_SWAP) < 0)
+			return -1;
+	}
+}
+
+int
+eve_wait_cmdempty(intptr_t devc, uint32_t timeout_ms)
+{
+	struct wait wait;
+	uint16_t space;
+
+	wait_init(&wait, devc, timeout_ms);
+
+	for (;;) {
+		if (cp_space(devc, &space) < 0)
+			return -1;
+		if (space == CP_SPACE_MAX)
+			return 0;
+
+		if (wait_event(&wait, EVE_IRQ_CMDEMPTY) < 0)
+			return -1;
+	}
+}
+
+void
+eve_cp_init(struct eve_cp *cp, intptr_t devc)
+{
+	assert(cp);
+
+	cp->devc = devc;
+	cp->len = 0;
+}
+
+int
+eve_cp_push(struct eve_cp *cp, uint32_t word)
+{
+	assert(cp);
+
+	if (cp->len >= EVE_CP_BUF_MAX && eve_cp_flush(cp) < 0)
+		return -1;
+
+	cp->buf[cp->len++] = word;
+
+	return 0;
+}
+
+int
+eve_cp_push_data(struct eve_cp *cp, const void *data, size_t size)
+{
+	assert(cp);
+	assert(data || size == 0);
+
+	const uint8_t *src = data;
+	size_t avail, n;
+
+	while (size) {
+		if (cp->len >= EVE_CP_BUF_MAX && eve_cp_flush(cp) < 0)
+			return -1;
+
+		avail = (EVE_CP_BUF_MAX - cp->len) * 4;
+		n = size < avail ? size : avail;
+
+		/* Last word gets zero padded. */
+		if (n % 4)
+			cp->buf[cp->len + n / 4] = 0;
+
+		memcpy(&cp->buf[cp->len], src, n);
+		cp->len += (n + 3) / 4;
+		src += n;
+		size -= n;
+	}
+
+	return 0;
+}
+
+int
+eve_cp_push_string(struct eve_cp *cp, const char *str)
+{
+	assert(str);
+
+	size_t len = strlen(str);
+
+	/* Always include the NUL terminator, even if that adds a whole word. */
+	if (eve_cp_push_data(cp, str, len) < 0)
+		return -1;
+
+	return len % 4 ? 0 : eve_cp_push(cp, 0);
+}
+
+int
+eve_cp_stream(struct eve_cp *cp, const void *data, size_t size)
+{
+	assert(cp);
+	assert(data || size == 0);
+
+	const uint8_t *src = data;
+	size_t words = size & ~(size_t)3;
+	int rc;
+
+	/* Staged words, the stream and its tail go in as one sequence. */
+	shadow_lock(EVE(cp->devc));
+
+	/* Whole words go straight from the caller memory. */
+	if ((rc = eve_cp_flush(cp)) == 0 && (rc = cp_write(cp->devc, src, words)) == 0) {
+		if (size % 4)
+			rc = eve_cp_push_data(cp, src + words, size % 4);
+		if (rc == 0)
+			rc = eve_cp_flush(cp);
+	}
+
+	shadow_unlock(EVE(cp->devc));
+
+	return rc;
+}
+
+int
+eve_cp_flush(struct eve_cp *cp)
+{
+	assert(cp);
+
+	size_t len = cp->len;
+
+	/* Pending words are dropped on error, the FIFO is in unknown state. */
+	cp->len = 0;
+
+	return cp_write(cp->devc, cp->buf, len * 4);
+}
+
+int
+eve_cp_send(intptr_t devc, const uint32_t *words, size_t n)
+{
+	assert(words || n == 0);
+
+	return cp_write(devc, words, n * 4);
+}
+
+int
+eve_cp_wait(struct eve_cp *cp)
+{
+	if (eve_cp_flush(cp) < 0)
+		return -1;
+
+	return eve_wait_cmdempty(cp->devc, EVE_WAIT_FOREVER);
+}
+
+int
+eve_cp_dlstart(struct eve_cp *cp)
+{
+	return eve_cp_push(cp, EVE_CPC_DLSTART);
+}
+
+int
+eve_cp_swap(struct eve_cp *cp)
+{
+	return eve_cp_push(cp, EVE_CPC_SWAP);
+}
+
+int
+eve_cp_memwrite(struct eve_cp *cp, uint32_t ptr, const void *data, size_t size)
+{
+	if (eve_cp_push(cp, EVE_CPC_MEMWRITE) < 0 ||
+	    eve_cp_push(cp, ptr) < 0 ||
+	    eve_cp_push(cp, size) < 0)
+		return -1;
+
+	return eve_cp_push_data(cp, data, size);
+}
+
+int
+eve_cp_memcpy(struct eve_cp *cp, uint32_t dest, uint32_t src, uint32_t num)
+{
+	if (eve_cp_push(cp, EVE_CPC_MEMCPY) < 0 ||
+	    eve_cp_push(cp, dest) < 0 ||
+	    eve_cp_push(cp, src) < 0)
+		return -1;
+
+	return eve_cp_push(cp, num);
+}
+
+int
+eve_cp_memset(struct eve_cp *cp, uint32_t ptr, uint8_t value, uint32_t num)
+{
+	if (eve_cp_push(cp, EVE_CPC_MEMSET) < 0 ||
+	    eve_cp_push(cp, ptr) < 0 ||
+	    eve_cp_push(cp, value) < 0)
+		return -1;
+
+	return eve_cp_push(cp, num);
+}
+
+int
+eve_cp_memzero(struct eve_cp *cp, uint32_t ptr, uint32_t num)
+{
+	if (eve_cp_push(cp, EVE_CPC_MEMZERO) < 0 ||
+	    eve_cp_push(cp, ptr) < 0)
+		return -1;
+
+	return eve_cp_push(cp, num);
+}
+
+int
+eve_cp_append(struct eve_cp *cp, uint32_t ptr, uint32_t num)
+{
+	if (eve_cp_push(cp, EVE_CPC_APPEND) < 0 ||
+	    eve_cp_push(cp, ptr) < 0)
+		return -1;
+
+	return eve_cp_push(cp, num);
+}
+
+int
+eve_cp_inflate(struct eve_cp *cp, uint32_t ptr)
+{
+	if (eve_cp_push(cp, EVE_CPC_INFLATE) < 0)
+		return -1;
+
+	return eve_cp_push(cp, ptr);
+}
+
+int
+eve_cp_loadimage(struct eve_cp *cp, uint32_t ptr, uint32_t options)
+{
+	if (eve_cp_push(cp, EVE_CPC_LOADIMAGE) < 0 ||
+	    eve_cp_push(cp, ptr) < 0)
+		return -1;
+
+	return eve_cp_push(cp, options);
+}
+
+int
+eve_cp_text(struct eve_cp *cp, int16_t x, int16_t y, int16_t font, uint16_t options, const char *str)
+{
+	if (eve_cp_push(cp, EVE_CPC_TEXT) < 0 ||
+	    eve_cp_push(cp, ((uint32_t)(uint16_t)y << 16) | (uint16_t)x) < 0 ||
+	    eve_cp_push(cp, ((uint32_t)options << 16) | (uint16_t)font) < 0)
+		return -1;
+
+	return eve_cp_push_string(cp, str);
+}
+
+void
+eve_dl_init(struct eve_dl *dl)
+{
+	assert(dl);
+
+	dl->len = 0;
+	dl->overflow = 0;
+}
+
+int
+eve_dl_push(struct eve_dl *dl, uint32_t word)
+{
+	assert(dl);
+
+	if (dl->len >= EVE_DL_MAX) {
+		dl->overflow = 1;
+		return -1;
+	}
+
+	dl->buf[dl->len++] = word;
+
+	return 0;
+}
+
+int
+eve_dl_append(struct eve_dl *dl, const uint32_t *words, size_t n)
+{
+	assert(dl);
+	assert(words || n == 0);
+
+	if (n > EVE_DL_MAX - dl->len) {
+		dl->overflow = 1;
+		return -1;
+	}
+
+	memcpy(&dl->buf[dl->len], words, n * 4);
+	dl->len += n;
+
+	return 0;
+}
+
+void
+eve_dl_display(struct eve_dl *dl)
+{
+	eve_dl_push(dl, EVE_DLC_DISPLAY);
+}
+
+void
+eve_dl_begin(struct eve_dl *dl, uint32_t prim)
+{
+	eve_dl_push(dl, EVE__DL_BEGIN(prim));
+}
+
+void
+eve_dl_end(struct eve_dl *dl)
+{
+	eve_dl_push(dl, EVE_DLC_END);
+}
+
+void
+eve_dl_clear(struct eve_dl *dl, uint32_t flags)
+{
+	eve_dl_push(dl, EVE_DLC_CLEAR | (flags & 0x7));
+}
+
+void
+eve_dl_clear_color_rgb(struct eve_dl *dl, uint8_t r, uint8_t g, uint8_t b)
+{
+	eve_dl_push(dl, EVE__DL_CLEAR_COLOR_RGB(r, g, b));
+}
+
+void
+eve_dl_clear_color_a(struct eve_dl *dl, uint8_t a)
+{
+	eve_dl_push(dl, EVE__DL_CLEAR_COLOR_A(a));
+}
+
+void
+eve_dl_color_rgb(struct eve_dl *dl, uint8_t r, uint8_t g, uint8_t b)
+{
+	eve_dl_push(dl, EVE__DL_COLOR_RGB(r, g, b));
+}
+
+void
+eve_dl_color_a(struct eve_dl *dl, uint8_t a)
+{
+	eve_dl_push(dl, EVE__DL_COLOR_A(a));
+}
+
+void
+eve_dl_point_size(struct eve_dl *dl, uint16_t size)
+{
+	eve_dl_push(dl, EVE__DL_POINT_SIZE(size));
+}
+
+void
+eve_dl_line_width(struct eve_dl *dl, uint16_t width)
+{
+	eve_dl_push(dl, EVE__DL_LINE_WIDTH(width));
+}
+
+void
+eve_dl_tag(struct eve_dl *dl, uint8_t tag)
+{
+	eve_dl_push(dl, EVE__DL_TAG(tag));
+}
+
+void
+eve_dl_tag_mask(struct eve_dl *dl, int enable)
+{
+	eve_dl_push(dl, EVE__DL_TAG_MASK(enable ? 1 : 0));
+}
+
+void
+eve_dl_scissor_xy(struct eve_dl *dl, uint16_t x, uint16_t y)
+{
+	eve_dl_push(dl, EVE__DL_SCISSOR_XY(x, y));
+}
+
+void
+eve_dl_scissor_size(struct eve_dl *dl, uint16_t width, uint16_t height)
+{
+	eve_dl_push(dl, EVE__DL_SCISSOR_SIZE(width, height));
+}
+
+void
+eve_dl_save_context(struct eve_dl *dl)
+{
+	eve_dl_push(dl, EVE_DLC_SAVE_CONTEXT);
+}
+
+void
+eve_dl_restore_context(struct eve_dl *dl)
+{
+	eve_dl_push(dl, EVE_DLC_RESTORE_CONTEXT);
+}
+
+void
+eve_dl_vertex_format(struct eve_dl *dl, uint8_t frac)
+{
+	eve_dl_push(dl, EVE__DL_VERTEX_FORMAT(frac));
+}
+
+void
+eve_dl_bitmap_handle(struct eve_dl *dl, uint8_t handle)
+{
+	eve_dl_push(dl, EVE__DL_BITMAP_HANDLE(handle));
+}
+
+void
+eve_dl_bitmap_source(struct eve_dl *dl, uint32_t address)
+{
+	eve_dl_push(dl, EVE__DL_BITMAP_SOURCE(address));
+}
+
+void
+eve_dl_bitmap_layout(struct eve_dl *dl, uint8_t format, uint16_t stride, uint16_t height)
+{
+	eve_dl_push(dl, EVE__DL_BITMAP_LAYOUT(format, stride, height));
+	eve_dl_push(dl, EVE__DL_BITMAP_LAYOUT_H(stride, height));
+}
+
+void
+eve_dl_bitmap_size(struct eve_dl *dl, uint8_t filter, uint8_t wrapx, uint8_t wrapy, uint16_t width, uint16_t height)
+{
+	eve_dl_push(dl, EVE__DL_BITMAP_SIZE(filter, wrapx, wrapy, width, height));
+	eve_dl_push(dl, EVE__DL_BITMAP_SIZE_H(width, height));
+}
+
+void
+eve_dl_bitmap_ext_format(struct eve_dl *dl, uint16_t format)
+{
+	eve_dl_push(dl, EVE__DL_BITMAP_EXT_FORMAT(format));
+}
+
+void
+eve_dl_cell(struct eve_dl *dl, uint8_t cell)
+{
+	eve_dl_push(dl, EVE__DL_CELL(cell));
+}
+
+void
+eve_dl_vertex2f(struct eve_dl *dl, int16_t x, int16_t y)
+{
+	eve_dl_push(dl, EVE__DL_VERTEX2F(x, y));
+}
+
+void
+eve_dl_vertex2ii(struct eve_dl *dl, uint16_t x, uint16_t y, uint8_t handle, uint8_t cell)
+{
+	eve_dl_push(dl, EVE__DL_VERTEX2II(x, y, handle, cell));
+}
+
+int
+eve_dl_upload(intptr_t devc, const struct eve_dl *dl)
+{
+	assert(dl);
+
+	if (dl->overflow)
+		return -1;
+
+	return eve_write(devc, EVE_MAP_RAM_DL, dl->buf, dl->len * 4);
+}
+
+int
+eve_dl_swap(intptr_t devc, const struct eve_dl *dl)
+{
+	if (eve_dl_upload(devc, dl) < 0)
+		return -1;
+
+	return eve_write8(devc, EVE_REG_DLSWAP, EVE_DLSWAP_FRAME);
+}
+
+void
+eve_dl_shadow_init(struct eve_dl_shadow *shadow)
+{
+	assert(shadow);
+
+	shadow->index = 0;
+	shadow->len[0] = shadow->len[1] = 0;
+	shadow->bytes_full = shadow->bytes_sent = 0;
+}
+
+int
+eve_dl_swap_delta(intptr_t devc, struct eve_dl_shadow *shadow, const struct eve_dl *dl)
+{
+	assert(shadow);
+	assert(dl);
+
+	struct {
+		size_t start;
+		size_t end;
+	} runs[EVE_DL_DELTA_RUNS];
+	uint32_t *prev = shadow->buf[shadow->index];
+	size_t plen = shadow->len[shadow->index], nruns = 0, bytes = 0;
+	int full = plen == 0;
+
+	if (dl->overflow)
+		return -1;
+
+	/* Collect the changed runs, merging the ones close to each other. */
+	for (size_t i = 0; !full && i < dl->len; ++i) {
+		if (i < plen && dl->buf[i] == prev[i])
+			continue;
+
+		if (nruns && i - runs[nruns - 1].end <= EVE_DL_DELTA_GAP)
+			runs[nruns - 1].end = i + 1;
+		else if (nruns == EVE_DL_DELTA_RUNS)
+			full = 1;
+		else {
+			runs[nruns].start = i;
+			runs[nruns++].end = i + 1;
+		}
+	}
+
+	for (size_t i = 0; !full && i < nruns; ++i)
+		bytes += (runs[i].end - runs[i].start) * 4;
+
+	if (bytes * 100 > dl->len * 4 * EVE_DL_DELTA_RATIO)
+		full = 1;
+
+	if (full) {
+		if (eve_dl_upload(devc, dl) < 0)
+			goto invalidate;
+
+		bytes = dl->len * 4;
+	} else {
+		for (size_t i = 0; i < nruns; ++i) {
+			if (eve_write(devc,
+			              EVE_MAP_RAM_DL + runs[i].start * 4,
+			              &dl->buf[runs[i].start],
+			              (runs[i].end - runs[i].start) * 4) < 0)
+				goto invalidate;
+		}
+	}
+
+	/* Not swapped, the buffer stays the back one with unknown content. */
+	if (eve_write8(devc, EVE_REG_DLSWAP, EVE_DLSWAP_FRAME) < 0)
+		goto invalidate;
+
+	memcpy(prev, dl->buf, dl->len * 4);
+	shadow->len[shadow->index] = dl->len;
+	shadow->index ^= 1;
+	shadow->bytes_full += dl->len * 4;
+	shadow->bytes_sent += bytes;
+
+	return 0;
+
+invalidate:
+	/* Partially written, can't trust this buffer anymore. */
+	shadow->len[shadow->index] = 0;
+
+	return -1;
+}
+
+void
+eve_finish(intptr_t devc)
+{
+	if (!devc)
+		return;
+
+	EVE(devc)->ops->finish(EVE(devc));
+}
@@ -23,6 +23,9 @@
 #define EVE_CMD_PINDRIVE                ((uint8_t)0x70)
 #define EVE_CMD_PIN_PD_STAT             ((uint8_t)0x71)
 
+/* Value of EVE_REG_ID once the device is up. */
+#define EVE_ID                          ((uint8_t)0x7c)
+
 /* Interrupts (p4.1.6) */
 #define EVE_IRQ_SWAP                    ((uint8_t)0x01)
 #define EVE_IRQ_TOUCH                   ((uint8_t)0x02)
@@ -87,7 +90,7 @@
 #define EVE_REG_INT_MASK                ((uint32_t)0x3020B0) /* rw, 8b   */
 #define EVE_REG_PLAYBACK_START          ((uint32_t)0x3020B4) /* rw, 20b  */
 #define EVE_REG_PLAYBACK_LENGTH         ((uint32_t)0x3020B8) /* rw, 20b  */
-#define EVE_REG_PLAYBACK_READPTR        ((uint32_t)0x3020B8) /* ro, 20b  */
+#define EVE_REG_PLAYBACK_READPTR        ((uint32_t)0x3020BC) /* ro, 20b  */
 #define EVE_REG_PLAYBACK_FREQ           ((uint32_t)0x3020C0) /* rw, 16b  */
 #define EVE_REG_PLAYBACK_FORMAT         ((uint32_t)0x3020C4) /* rw, 2b   */
 #define EVE_REG_PLAYBACK_LOOP           ((uint32_t)0x3020C8) /* rw, 1b   */
@@ -157,6 +160,9 @@
 #define EVE_MAP_RAM_CMD                 ((uint32_t)0x00308000) /* 4kB */
 #define EVE_MAP_FLASH                   ((uint32_t)0x00800000) /* 256MB */
 
+/* Address of the ROM font metric blocks, for fonts 16 and up. */
+#define EVE_ROM_FONTROOT                ((uint32_t)0x002ffffc)
+
 /* Display List Commands (p4). */
 #define EVE_DLC_ALPHA_FUNC              ((uint32_t)0x09000000)
 #define EVE_DLC_BEGIN                   ((uint32_t)0x1f000000)
@@ -203,11 +209,337 @@
 #define EVE_DLC_STENCIL_OP              ((uint32_t)0x0c000000)
 #define EVE_DLC_TAG                     ((uint32_t)0x03000000)
 #define EVE_DLC_TAG_MASK                ((uint32_t)0x14000000)
-#define EVE_DLC_VERTEX2F                ((uint32_t)0x01000000)
-#define EVE_DLC_VERTEX2II               ((uint32_t)0x02000000)
+#define EVE_DLC_VERTEX2F                ((uint32_t)0x40000000)
+#define EVE_DLC_VERTEX2II               ((uint32_t)0x80000000)
 #define EVE_DLC_VERTEX_FORMAT           ((uint32_t)0x27000000)
 #define EVE_DLC_VERTEX_TRANSLATE_X      ((uint32_t)0x2b000000)
-#define EVE_DLC_VERTEX_TRANSLATE_Y      ((uint32_t)0x2c000000
+#define EVE_DLC_VERTEX_TRANSLATE_Y      ((uint32_t)0x2c000000)
+
+/*
+ * Display list command encoders.
+ *
+ * EVE_DL_* are constant expressions meant for static lists: every field is
+ * range checked at compile time, an out of range value or a non constant
+ * argument fails the build. EVE__DL_* encode the same words without checks,
+ * fields are masked to their width, for values only known at run time.
+ *
+ *   static const uint32_t chrome[] = {
+ *           EVE_DL_CLEAR_COLOR_RGB(0x00, 0x0f, 0xf0),
+ *           EVE_DL_CLEAR(1, 1, 1),
+ *           EVE_DL_DISPLAY(),
+ *   };
+ */
+#define EVE__BITS(v, bits, shift)       (((uint32_t)(v) & ((1U << (bits)) - 1)) << (shift))
+#define EVE__ASSERT(cond)               ((uint32_t)(0 * sizeof (struct { int eve_out_of_range : (cond) ? 1 : -1; })))
+#define EVE__U(v, bits)                 EVE__ASSERT((v) >= 0 && (v) < (1L << (bits)))
+#define EVE__S(v, bits)                 EVE__ASSERT((v) >= -(1L << ((bits) - 1)) && (v) < (1L << ((bits) - 1)))
+
+#define EVE__DL_ALPHA_FUNC(func, ref) \
+	(EVE_DLC_ALPHA_FUNC | EVE__BITS(func, 3, 8) | EVE__BITS(ref, 8, 0))
+#define EVE__DL_BEGIN(prim) \
+	(EVE_DLC_BEGIN | EVE__BITS(prim, 4, 0))
+#define EVE__DL_BITMAP_EXT_FORMAT(format) \
+	(EVE_DLC_BITMAP_EXT_FORMAT | EVE__BITS(format, 16, 0))
+#define EVE__DL_BITMAP_HANDLE(handle) \
+	(EVE_DLC_BITMAP_HANDLE | EVE__BITS(handle, 5, 0))
+#define EVE__DL_BITMAP_LAYOUT(format, stride, height) \
+	(EVE_DLC_BITMAP_LAYOUT | EVE__BITS(format, 5, 19) | EVE__BITS(stride, 10, 9) | EVE__BITS(height, 9, 0))
+#define EVE__DL_BITMAP_LAYOUT_H(stride, height) \
+	(EVE_DLC_BITMAP_LAYOUT_H | EVE__BITS((stride) >> 10, 2, 2) | EVE__BITS((height) >> 9, 2, 0))
+#define EVE__DL_BITMAP_SIZE(filter, wrapx, wrapy, width, height) \
+	(EVE_DLC_BITMAP_SIZE | EVE__BITS(filter, 1, 20) | EVE__BITS(wrapx, 1, 19) | EVE__BITS(wrapy, 1, 18) | \
+	 EVE__BITS(width, 9, 9) | EVE__BITS(height, 9, 0))
+#define EVE__DL_BITMAP_SIZE_H(width, height) \
+	(EVE_DLC_BITMAP_SIZE_H | EVE__BITS((width) >> 9, 2, 2) | EVE__BITS((height) >> 9, 2, 0))
+#define EVE__DL_BITMAP_SOURCE(address) \
+	(EVE_DLC_BITMAP_SOURCE | EVE__BITS(address, 24, 0))
+#define EVE__DL_BITMAP_SWIZZLE(r, g, b, a) \
+	(EVE_DLC_BITMAP_SWIZZLE | EVE__BITS(r, 3, 9) | EVE__BITS(g, 3, 6) | EVE__BITS(b, 3, 3) | EVE__BITS(a, 3, 0))
+#define EVE__DL_BITMAP_TRANSFORM_A(p, v) \
+	(EVE_DLC_BITMAP_TRANSFORM_A | EVE__BITS(p, 1, 17) | EVE__BITS(v, 17, 0))
+#define EVE__DL_BITMAP_TRANSFORM_B(p, v) \
+	(EVE_DLC_BITMAP_TRANSFORM_B | EVE__BITS(p, 1, 17) | EVE__BITS(v, 17, 0))
+#define EVE__DL_BITMAP_TRANSFORM_C(v) \
+	(EVE_DLC_BITMAP_TRANSFORM_C | EVE__BITS(v, 24, 0))
+#define EVE__DL_BITMAP_TRANSFORM_D(p, v) \
+	(EVE_DLC_BITMAP_TRANSFORM_D | EVE__BITS(p, 1, 17) | EVE__BITS(v, 17, 0))
+#define EVE__DL_BITMAP_TRANSFORM_E(p, v) \
+	(EVE_DLC_BITMAP_TRANSFORM_E | EVE__BITS(p, 1, 17) | EVE__BITS(v, 17, 0))
+#define EVE__DL_BITMAP_TRANSFORM_F(v) \
+	(EVE_DLC_BITMAP_TRANSFORM_F | EVE__BITS(v, 24, 0))
+#define EVE__DL_BLEND_FUNC(src, dst) \
+	(EVE_DLC_BLEND_FUNC | EVE__BITS(src, 3, 3) | EVE__BITS(dst, 3, 0))
+#define EVE__DL_CALL(dest) \
+	(EVE_DLC_CALL | EVE__BITS(dest, 16, 0))
+#define EVE__DL_CELL(cell) \
+	(EVE_DLC_CELL | EVE__BITS(cell, 7, 0))
+#define EVE__DL_CLEAR(color, stencil, tag) \
+	(EVE_DLC_CLEAR | EVE__BITS(color, 1, 2) | EVE__BITS(stencil, 1, 1) | EVE__BITS(tag, 1, 0))
+#define EVE__DL_CLEAR_COLOR_A(a) \
+	(EVE_DLC_CLEAR_COLOR_A | EVE__BITS(a, 8, 0))
+#define EVE__DL_CLEAR_COLOR_RGB(r, g, b) \
+	(EVE_DLC_CLEAR_COLOR_RGB | EVE__BITS(r, 8, 16) | EVE__BITS(g, 8, 8) | EVE__BITS(b, 8, 0))
+#define EVE__DL_CLEAR_STENCIL(s) \
+	(EVE_DLC_CLEAR_STENCIL | EVE__BITS(s, 8, 0))
+#define EVE__DL_CLEAR_TAG(tag) \
+	(EVE_DLC_CLEAR_TAG | EVE__BITS(tag, 8, 0))
+#define EVE__DL_COLOR_A(a) \
+	(EVE_DLC_COLOR_A | EVE__BITS(a, 8, 0))
+#define EVE__DL_COLOR_MASK(r, g, b, a) \
+	(EVE_DLC_COLOR_MASK | EVE__BITS(r, 1, 3) | EVE__BITS(g, 1, 2) | EVE__BITS(b, 1, 1) | EVE__BITS(a, 1, 0))
+#define EVE__DL_COLOR_RGB(r, g, b) \
+	(EVE_DLC_COLOR_RGB | EVE__BITS(r, 8, 16) | EVE__BITS(g, 8, 8) | EVE__BITS(b, 8, 0))
+#define EVE__DL_JUMP(dest) \
+	(EVE_DLC_JUMP | EVE__BITS(dest, 16, 0))
+#define EVE__DL_LINE_WIDTH(width) \
+	(EVE_DLC_LINE_WIDTH | EVE__BITS(width, 12, 0))
+#define EVE__DL_MACRO(m) \
+	(EVE_DLC_MACRO | EVE__BITS(m, 1, 0))
+#define EVE__DL_PALETTE_SOURCE(address) \
+	(EVE_DLC_PALETTE_SOURCE | EVE__BITS(address, 22, 0))
+#define EVE__DL_POINT_SIZE(size) \
+	(EVE_DLC_POINT_SIZE | EVE__BITS(size, 13, 0))
+#define EVE__DL_SCISSOR_SIZE(width, height) \
+	(EVE_DLC_SCISSOR_SIZE | EVE__BITS(width, 12, 12) | EVE__BITS(height, 12, 0))
+#define EVE__DL_SCISSOR_XY(x, y) \
+	(EVE_DLC_SCISSOR_XY | EVE__BITS(x, 11, 11) | EVE__BITS(y, 11, 0))
+#define EVE__DL_STENCIL_FUNC(func, ref, mask) \
+	(EVE_DLC_STENCIL_FUNC | EVE__BITS(func, 4, 16) | EVE__BITS(ref, 8, 8) | EVE__BITS(mask, 8, 0))
+#define EVE__DL_STENCIL_MASK(mask) \
+	(EVE_DLC_STENCIL_MASK | EVE__BITS(mask, 8, 0))
+#define EVE__DL_STENCIL_OP(sfail, spass) \
+	(EVE_DLC_STENCIL_OP | EVE__BITS(sfail, 3, 3) | EVE__BITS(spass, 3, 0))
+#define EVE__DL_TAG(tag) \
+	(EVE_DLC_TAG | EVE__BITS(tag, 8, 0))
+#define EVE__DL_TAG_MASK(mask) \
+	(EVE_DLC_TAG_MASK | EVE__BITS(mask, 1, 0))
+#define EVE__DL_VERTEX2F(x, y) \
+	(EVE_DLC_VERTEX2F | EVE__BITS(x, 15, 15) | EVE__BITS(y, 15, 0))
+#define EVE__DL_VERTEX2II(x, y, handle, cell) \
+	(EVE_DLC_VERTEX2II | EVE__BITS(x, 9, 21) | EVE__BITS(y, 9, 12) | EVE__BITS(handle, 5, 7) | EVE__BITS(cell, 7, 0))
+#define EVE__DL_VERTEX_FORMAT(frac) \
+	(EVE_DLC_VERTEX_FORMAT | EVE__BITS(frac, 3, 0))
+#define EVE__DL_VERTEX_TRANSLATE_X(x) \
+	(EVE_DLC_VERTEX_TRANSLATE_X | EVE__BITS(x, 17, 0))
+#define EVE__DL_VERTEX_TRANSLATE_Y(y) \
+	(EVE_DLC_VERTEX_TRANSLATE_Y | EVE__BITS(y, 17, 0))
+
+#define EVE_DL_ALPHA_FUNC(func, ref) \
+	(EVE__DL_ALPHA_FUNC(func, ref) + EVE__U(func, 3) + EVE__U(ref, 8))
+#define EVE_DL_BEGIN(prim) \
+	(EVE__DL_BEGIN(prim) + EVE__U(prim, 4))
+#define EVE_DL_BITMAP_EXT_FORMAT(format) \
+	(EVE__DL_BITMAP_EXT_FORMAT(format) + EVE__U(format, 16))
+#define EVE_DL_BITMAP_HANDLE(handle) \
+	(EVE__DL_BITMAP_HANDLE(handle) + EVE__U(handle, 5))
+#define EVE_DL_BITMAP_LAYOUT(format, stride, height) \
+	(EVE__DL_BITMAP_LAYOUT(format, stride, height) + EVE__U(format, 5) + EVE__U(stride, 12) + EVE__U(height, 11))
+#define EVE_DL_BITMAP_LAYOUT_H(stride, height) \
+	(EVE__DL_BITMAP_LAYOUT_H(stride, height) + EVE__U(stride, 12) + EVE__U(height, 11))
+#define EVE_DL_BITMAP_SIZE(filter, wrapx, wrapy, width, height) \
+	(EVE__DL_BITMAP_SIZE(filter, wrapx, wrapy, width, height) + EVE__U(filter, 1) + \
+	 EVE__U(wrapx, 1) + EVE__U(wrapy, 1) + EVE__U(width, 11) + EVE__U(height, 11))
+#define EVE_DL_BITMAP_SIZE_H(width, height) \
+	(EVE__DL_BITMAP_SIZE_H(width, height) + EVE__U(width, 11) + EVE__U(height, 11))
+#define EVE_DL_BITMAP_SOURCE(address) \
+	(EVE__DL_BITMAP_SOURCE(address) + EVE__U(address, 24))
+#define EVE_DL_BITMAP_SWIZZLE(r, g, b, a) \
+	(EVE__DL_BITMAP_SWIZZLE(r, g, b, a) + EVE__U(r, 3) + EVE__U(g, 3) + EVE__U(b, 3) + EVE__U(a, 3))
+#define EVE_DL_BITMAP_TRANSFORM_A(p, v) \
+	(EVE__DL_BITMAP_TRANSFORM_A(p, v) + EVE__U(p, 1) + EVE__S(v, 17))
+#define EVE_DL_BITMAP_TRANSFORM_B(p, v) \
+	(EVE__DL_BITMAP_TRANSFORM_B(p, v) + EVE__U(p, 1) + EVE__S(v, 17))
+#define EVE_DL_BITMAP_TRANSFORM_C(v) \
+	(EVE__DL_BITMAP_TRANSFORM_C(v) + EVE__S(v, 24))
+#define EVE_DL_BITMAP_TRANSFORM_D(p, v) \
+	(EVE__DL_BITMAP_TRANSFORM_D(p, v) + EVE__U(p, 1) + EVE__S(v, 17))
+#define EVE_DL_BITMAP_TRANSFORM_E(p, v) \
+	(EVE__DL_BITMAP_TRANSFORM_E(p, v) + EVE__U(p, 1) + EVE__S(v, 17))
+#define EVE_DL_BITMAP_TRANSFORM_F(v) \
+	(EVE__DL_BITMAP_TRANSFORM_F(v) + EVE__S(v, 24))
+#define EVE_DL_BLEND_FUNC(src, dst) \
+	(EVE__DL_BLEND_FUNC(src, dst) + EVE__U(src, 3) + EVE__U(dst, 3))
+#define EVE_DL_CALL(dest) \
+	(EVE__DL_CALL(dest) + EVE__U(dest, 16))
+#define EVE_DL_CELL(cell) \
+	(EVE__DL_CELL(cell) + EVE__U(cell, 7))
+#define EVE_DL_CLEAR(color, stencil, tag) \
+	(EVE__DL_CLEAR(color, stencil, tag) + EVE__U(color, 1) + EVE__U(stencil, 1) + EVE__U(tag, 1))
+#define EVE_DL_CLEAR_COLOR_A(a) \
+	(EVE__DL_CLEAR_COLOR_A(a) + EVE__U(a, 8))
+#define EVE_DL_CLEAR_COLOR_RGB(r, g, b) \
+	(EVE__DL_CLEAR_COLOR_RGB(r, g, b) + EVE__U(r, 8) + EVE__U(g, 8) + EVE__U(b, 8))
+#define EVE_DL_CLEAR_STENCIL(s) \
+	(EVE__DL_CLEAR_STENCIL(s) + EVE__U(s, 8))
+#define EVE_DL_CLEAR_TAG(tag) \
+	(EVE__DL_CLEAR_TAG(tag) + EVE__U(tag, 8))
+#define EVE_DL_COLOR_A(a) \
+	(EVE__DL_COLOR_A(a) + EVE__U(a, 8))
+#define EVE_DL_COLOR_MASK(r, g, b, a) \
+	(EVE__DL_COLOR_MASK(r, g, b, a) + EVE__U(r, 1) + EVE__U(g, 1) + EVE__U(b, 1) + EVE__U(a, 1))
+#define EVE_DL_COLOR_RGB(r, g, b) \
+	(EVE__DL_COLOR_RGB(r, g, b) + EVE__U(r, 8) + EVE__U(g, 8) + EVE__U(b, 8))
+#define EVE_DL_DISPLAY()                EVE_DLC_DISPLAY
+#define EVE_DL_END()                    EVE_DLC_END
+#define EVE_DL_JUMP(dest) \
+	(EVE__DL_JUMP(dest) + EVE__U(dest, 16))
+#define EVE_DL_LINE_WIDTH(width) \
+	(EVE__DL_LINE_WIDTH(width) + EVE__U(width, 12))
+#define EVE_DL_MACRO(m) \
+	(EVE__DL_MACRO(m) + EVE__U(m, 1))
+#define EVE_DL_NOP()                    EVE_DLC_NOP
+#define EVE_DL_PALETTE_SOURCE(address) \
+	(EVE__DL_PALETTE_SOURCE(address) + EVE__U(address, 22))
+#define EVE_DL_POINT_SIZE(size) \
+	(EVE__DL_POINT_SIZE(size) + EVE__U(size, 13))
+#define EVE_DL_RESTORE_CONTEXT()        EVE_DLC_RESTORE_CONTEXT
+#define EVE_DL_RETURN()                 EVE_DLC_RETURN
+#define EVE_DL_SAVE_CONTEXT()           EVE_DLC_SAVE_CONTEXT
+#define EVE_DL_SCISSOR_SIZE(width, height) \
+	(EVE__DL_SCISSOR_SIZE(width, height) + EVE__U(width, 12) + EVE__U(height, 12))
+#define EVE_DL_SCISSOR_XY(x, y) \
+	(EVE__DL_SCISSOR_XY(x, y) + EVE__U(x, 11) + EVE__U(y, 11))
+#define EVE_DL_STENCIL_FUNC(func, ref, mask) \
+	(EVE__DL_STENCIL_FUNC(func, ref, mask) + EVE__U(func, 4) + EVE__U(ref, 8) + EVE__U(mask, 8))
+#define EVE_DL_STENCIL_MASK(mask) \
+	(EVE__DL_STENCIL_MASK(mask) + EVE__U(mask, 8))
+#define EVE_DL_STENCIL_OP(sfail, spass) \
+	(EVE__DL_STENCIL_OP(sfail, spass) + EVE__U(sfail, 3) + EVE__U(spass, 3))
+#define EVE_DL_TAG(tag) \
+	(EVE__DL_TAG(tag) + EVE__U(tag, 8))
+#define EVE_DL_TAG_MASK(mask) \
+	(EVE__DL_TAG_MASK(mask) + EVE__U(mask, 1))
+#define EVE_DL_VERTEX2F(x, y) \
+	(EVE__DL_VERTEX2F(x, y) + EVE__S(x, 15) + EVE__S(y, 15))
+#define EVE_DL_VERTEX2II(x, y, handle, cell) \
+	(EVE__DL_VERTEX2II(x, y, handle, cell) + EVE__U(x, 9) + EVE__U(y, 9) + EVE__U(handle, 5) + EVE__U(cell, 7))
+#define EVE_DL_VERTEX_FORMAT(frac) \
+	(EVE__DL_VERTEX_FORMAT(frac) + EVE__U(frac, 3))
+#define EVE_DL_VERTEX_TRANSLATE_X(x) \
+	(EVE__DL_VERTEX_TRANSLATE_X(x) + EVE__S(x, 17))
+#define EVE_DL_VERTEX_TRANSLATE_Y(y) \
+	(EVE__DL_VERTEX_TRANSLATE_Y(y) + EVE__S(y, 17))
+
+/* Coprocessor commands (p5). */
+#define EVE_CPC_DLSTART                 ((uint32_t)0xffffff00)
+#define EVE_CPC_SWAP                    ((uint32_t)0xffffff01)
+#define EVE_CPC_INTERRUPT               ((uint32_t)0xffffff02)
+#define EVE_CPC_BGCOLOR                 ((uint32_t)0xffffff09)
+#define EVE_CPC_FGCOLOR                 ((uint32_t)0xffffff0a)
+#define EVE_CPC_GRADIENT                ((uint32_t)0xffffff0b)
+#define EVE_CPC_TEXT                    ((uint32_t)0xffffff0c)
+#define EVE_CPC_BUTTON                  ((uint32_t)0xffffff0d)
+#define EVE_CPC_KEYS                    ((uint32_t)0xffffff0e)
+#define EVE_CPC_PROGRESS                ((uint32_t)0xffffff0f)
+#define EVE_CPC_SLIDER                  ((uint32_t)0xffffff10)
+#define EVE_CPC_SCROLLBAR               ((uint32_t)0xffffff11)
+#define EVE_CPC_TOGGLE                  ((uint32_t)0xffffff12)
+#define EVE_CPC_GAUGE                   ((uint32_t)0xffffff13)
+#define EVE_CPC_CLOCK                   ((uint32_t)0xffffff14)
+#define EVE_CPC_CALIBRATE               ((uint32_t)0xffffff15)
+#define EVE_CPC_SPINNER                 ((uint32_t)0xffffff16)
+#define EVE_CPC_STOP                    ((uint32_t)0xffffff17)
+#define EVE_CPC_MEMCRC                  ((uint32_t)0xffffff18)
+#define EVE_CPC_REGREAD                 ((uint32_t)0xffffff19)
+#define EVE_CPC_MEMWRITE                ((uint32_t)0xffffff1a)
+#define EVE_CPC_MEMSET                  ((uint32_t)0xffffff1b)
+#define EVE_CPC_MEMZERO                 ((uint32_t)0xffffff1c)
+#define EVE_CPC_MEMCPY                  ((uint32_t)0xffffff1d)
+#define EVE_CPC_APPEND                  ((uint32_t)0xffffff1e)
+#define EVE_CPC_SNAPSHOT                ((uint32_t)0xffffff1f)
+#define EVE_CPC_INFLATE                 ((uint32_t)0xffffff22)
+#define EVE_CPC_GETPTR                  ((uint32_t)0xffffff23)
+#define EVE_CPC_LOADIMAGE               ((uint32_t)0xffffff24)
+#define EVE_CPC_GETPROPS                ((uint32_t)0xffffff25)
+#define EVE_CPC_LOADIDENTITY            ((uint32_t)0xffffff26)
+#define EVE_CPC_TRANSLATE               ((uint32_t)0xffffff27)
+#define EVE_CPC_SCALE                   ((uint32_t)0xffffff28)
+#define EVE_CPC_ROTATE                  ((uint32_t)0xffffff29)
+#define EVE_CPC_SETMATRIX               ((uint32_t)0xffffff2a)
+#define EVE_CPC_SETFONT                 ((uint32_t)0xffffff2b)
+#define EVE_CPC_TRACK                   ((uint32_t)0xffffff2c)
+#define EVE_CPC_DIAL                    ((uint32_t)0xffffff2d)
+#define EVE_CPC_NUMBER                  ((uint32_t)0xffffff2e)
+#define EVE_CPC_SCREENSAVER             ((uint32_t)0xffffff2f)
+#define EVE_CPC_SKETCH                  ((uint32_t)0xffffff30)
+#define EVE_CPC_LOGO                    ((uint32_t)0xffffff31)
+#define EVE_CPC_COLDSTART               ((uint32_t)0xffffff32)
+#define EVE_CPC_GETMATRIX               ((uint32_t)0xffffff33)
+#define EVE_CPC_GRADCOLOR               ((uint32_t)0xffffff34)
+#define EVE_CPC_SETROTATE               ((uint32_t)0xffffff36)
+#define EVE_CPC_SNAPSHOT2               ((uint32_t)0xffffff37)
+#define EVE_CPC_SETBASE                 ((uint32_t)0xffffff38)
+#define EVE_CPC_MEDIAFIFO               ((uint32_t)0xffffff39)
+#define EVE_CPC_PLAYVIDEO               ((uint32_t)0xffffff3a)
+#define EVE_CPC_SETFONT2                ((uint32_t)0xffffff3b)
+#define EVE_CPC_SETSCRATCH              ((uint32_t)0xffffff3c)
+#define EVE_CPC_ROMFONT                 ((uint32_t)0xffffff3f)
+#define EVE_CPC_VIDEOSTART              ((uint32_t)0xffffff40)
+#define EVE_CPC_VIDEOFRAME              ((uint32_t)0xffffff41)
+#define EVE_CPC_SYNC                    ((uint32_t)0xffffff42)
+#define EVE_CPC_SETBITMAP               ((uint32_t)0xffffff43)
+#define EVE_CPC_FLASHERASE              ((uint32_t)0xffffff44)
+#define EVE_CPC_FLASHWRITE              ((uint32_t)0xffffff45)
+#define EVE_CPC_FLASHREAD               ((uint32_t)0xffffff46)
+#define EVE_CPC_FLASHUPDATE             ((uint32_t)0xffffff47)
+#define EVE_CPC_FLASHDETACH             ((uint32_t)0xffffff48)
+#define EVE_CPC_FLASHATTACH             ((uint32_t)0xffffff49)
+#define EVE_CPC_FLASHFAST               ((uint32_t)0xffffff4a)
+#define EVE_CPC_FLASHSPIDESEL           ((uint32_t)0xffffff4b)
+#define EVE_CPC_FLASHSPITX              ((uint32_t)0xffffff4c)
+#define EVE_CPC_FLASHSPIRX              ((uint32_t)0xffffff4d)
+#define EVE_CPC_FLASHSOURCE             ((uint32_t)0xffffff4e)
+#define EVE_CPC_CLEARCACHE              ((uint32_t)0xffffff4f)
+#define EVE_CPC_INFLATE2                ((uint32_t)0xffffff50)
+#define EVE_CPC_ROTATEAROUND            ((uint32_t)0xffffff51)
+#define EVE_CPC_RESETFONTS              ((uint32_t)0xffffff52)
+#define EVE_CPC_ANIMSTART               ((uint32_t)0xffffff53)
+#define EVE_CPC_ANIMSTOP                ((uint32_t)0xffffff54)
+#define EVE_CPC_ANIMXY                  ((uint32_t)0xffffff55)
+#define EVE_CPC_ANIMDRAW                ((uint32_t)0xffffff56)
+#define EVE_CPC_GRADIENTA               ((uint32_t)0xffffff57)
+#define EVE_CPC_FILLWIDTH               ((uint32_t)0xffffff58)
+#define EVE_CPC_APPENDF                 ((uint32_t)0xffffff59)
+#define EVE_CPC_ANIMFRAME               ((uint32_t)0xffffff5a)
+
+/* Coprocessor options (p5.6). */
+#define EVE_OPT_3D                      ((uint16_t)0x0000)
+#define EVE_OPT_RGB565                  ((uint16_t)0x0000)
+#define EVE_OPT_MONO                    ((uint16_t)0x0001)
+#define EVE_OPT_NODL                    ((uint16_t)0x0002)
+#define EVE_OPT_NOTEAR                  ((uint16_t)0x0004)
+#define EVE_OPT_FULLSCREEN              ((uint16_t)0x0008)
+#define EVE_OPT_MEDIAFIFO               ((uint16_t)0x0010)
+#define EVE_OPT_SOUND                   ((uint16_t)0x0020)
+#define EVE_OPT_FLASH                   ((uint16_t)0x0040)
+#define EVE_OPT_FLAT                    ((uint16_t)0x0100)
+#define EVE_OPT_SIGNED                  ((uint16_t)0x0100)
+#define EVE_OPT_CENTERX                 ((uint16_t)0x0200)
+#define EVE_OPT_CENTERY                 ((uint16_t)0x0400)
+#define EVE_OPT_CENTER                  ((uint16_t)0x0600)
+#define EVE_OPT_RIGHTX                  ((uint16_t)0x0800)
+#define EVE_OPT_NOBACK                  ((uint16_t)0x1000)
+#define EVE_OPT_FORMAT                  ((uint16_t)0x1000)
+#define EVE_OPT_FILL                    ((uint16_t)0x2000)
+#define EVE_OPT_NOTICKS                 ((uint16_t)0x2000)
+#define EVE_OPT_NOHM                    ((uint16_t)0x4000)
+#define EVE_OPT_NOPOINTER               ((uint16_t)0x4000)
+#define EVE_OPT_NOSECS                  ((uint16_t)0x8000)
+#define EVE_OPT_NOHANDS                 ((uint16_t)0xc000)
+
+/*
+ * Size of the coprocessor command FIFO (RAM_CMD), REG_CMDB_SPACE reports at
+ * most EVE_CP_FIFO_SIZE - 4 bytes when the coprocessor is idle.
+ */
+#define EVE_CP_FIFO_SIZE                4096U
+
+/*
+ * Size of the host side coprocessor staging buffer in 32-bit words, one flush
+ * sends at most this amount of data in a single burst.
+ */
+#ifndef EVE_CP_BUF_MAX
+#       define EVE_CP_BUF_MAX           256
+#endif
 
 #define EVE_PRIM_BITMAPS                ((uint32_t)0x00000001)
 #define EVE_PRIM_POINTS                 ((uint32_t)0x00000002)
@@ -223,6 +555,121 @@
 #define EVE_CLEAR_STENCIL               ((uint32_t)0x00000002)
 #define EVE_CLEAR_COLOR                 ((uint32_t)0x00000004)
 
+/* Values for EVE_REG_DLSWAP. */
+#define EVE_DLSWAP_DONE                 ((uint8_t)0x00)
+#define EVE_DLSWAP_LINE                 ((uint8_t)0x01)
+#define EVE_DLSWAP_FRAME                ((uint8_t)0x02)
+
+/* Values for EVE_REG_FLASH_STATUS. */
+#define EVE_FLASH_STATUS_INIT           ((uint8_t)0x00)
+#define EVE_FLASH_STATUS_DETACHED       ((uint8_t)0x01)
+#define EVE_FLASH_STATUS_BASIC          ((uint8_t)0x02)
+#define EVE_FLASH_STATUS_FULL           ((uint8_t)0x03)
+
+/* Values for EVE_REG_PLAYBACK_FORMAT. */
+#define EVE_SAMPLES_LINEAR              ((uint8_t)0x00) /* 8-bit signed */
+#define EVE_SAMPLES_ULAW                ((uint8_t)0x01)
+#define EVE_SAMPLES_ADPCM               ((uint8_t)0x02) /* 4-bit IMA */
+
+/* Bitmap formats for BITMAP_LAYOUT and BITMAP_EXT_FORMAT. */
+#define EVE_FORMAT_ARGB1555             ((uint32_t)0x00000000)
+#define EVE_FORMAT_L1                   ((uint32_t)0x00000001)
+#define EVE_FORMAT_L4                   ((uint32_t)0x00000002)
+#define EVE_FORMAT_L8                   ((uint32_t)0x00000003)
+#define EVE_FORMAT_RGB332               ((uint32_t)0x00000004)
+#define EVE_FORMAT_ARGB2                ((uint32_t)0x00000005)
+#define EVE_FORMAT_ARGB4                ((uint32_t)0x00000006)
+#define EVE_FORMAT_RGB565               ((uint32_t)0x00000007)
+#define EVE_FORMAT_TEXT8X8              ((uint32_t)0x00000009)
+#define EVE_FORMAT_TEXTVGA              ((uint32_t)0x0000000a)
+#define EVE_FORMAT_BARGRAPH             ((uint32_t)0x0000000b)
+#define EVE_FORMAT_PALETTED565          ((uint32_t)0x0000000e)
+#define EVE_FORMAT_PALETTED4444         ((uint32_t)0x0000000f)
+#define EVE_FORMAT_PALETTED8            ((uint32_t)0x00000010)
+#define EVE_FORMAT_L2                   ((uint32_t)0x00000011)
+#define EVE_FORMAT_GLFORMAT             ((uint32_t)0x0000001f)
+#define EVE_FORMAT_ARGB8_SNAPSHOT       ((uint32_t)0x00000020) /* CMD_SNAPSHOT2 */
+
+/* ASTC formats, BITMAP_EXT_FORMAT only, blocks are always 16 bytes. */
+#define EVE_FORMAT_ASTC_4X4             ((uint32_t)0x000093b0)
+#define EVE_FORMAT_ASTC_5X4             ((uint32_t)0x000093b1)
+#define EVE_FORMAT_ASTC_5X5             ((uint32_t)0x000093b2)
+#define EVE_FORMAT_ASTC_6X5             ((uint32_t)0x000093b3)
+#define EVE_FORMAT_ASTC_6X6             ((uint32_t)0x000093b4)
+#define EVE_FORMAT_ASTC_8X5             ((uint32_t)0x000093b5)
+#define EVE_FORMAT_ASTC_8X6             ((uint32_t)0x000093b6)
+#define EVE_FORMAT_ASTC_8X8             ((uint32_t)0x000093b7)
+#define EVE_FORMAT_ASTC_10X5            ((uint32_t)0x000093b8)
+#define EVE_FORMAT_ASTC_10X6            ((uint32_t)0x000093b9)
+#define EVE_FORMAT_ASTC_10X8            ((uint32_t)0x000093ba)
+#define EVE_FORMAT_ASTC_10X10           ((uint32_t)0x000093bb)
+#define EVE_FORMAT_ASTC_12X10           ((uint32_t)0x000093bc)
+#define EVE_FORMAT_ASTC_12X12           ((uint32_t)0x000093bd)
+
+/* Size of RAM_DL in bytes and in display list commands. */
+#define EVE_DL_SIZE                     8192U
+#define EVE_DL_MAX                      (EVE_DL_SIZE / 4)
+
+/*
+ * Delta display list uploads: changed runs separated by at most
+ * EVE_DL_DELTA_GAP unchanged words are merged into one burst, and the whole
+ * list is uploaded instead once the delta goes over EVE_DL_DELTA_RUNS bursts
+ * or EVE_DL_DELTA_RATIO percent of the full list.
+ */
+#ifndef EVE_DL_DELTA_GAP
+#       define EVE_DL_DELTA_GAP         4
+#endif
+
+#ifndef EVE_DL_DELTA_RUNS
+#       define EVE_DL_DELTA_RUNS        32
+#endif
+
+#ifndef EVE_DL_DELTA_RATIO
+#       define EVE_DL_DELTA_RATIO       75
+#endif
+
+/*
+ * Boot timings in microseconds: PD low and high hold times before the core is
+ * activated, polling interval range for REG_ID/REG_CPURESET and how long each
+ * of them may take before the device is power cycled again.
+ */
+#ifndef EVE_BOOT_PD_LOW_US
+#       define EVE_BOOT_PD_LOW_US       5000
+#endif
+
+#ifndef EVE_BOOT_PD_HIGH_US
+#       define EVE_BOOT_PD_HIGH_US      20000
+#endif
+
+#ifndef EVE_BOOT_POLL_MIN_US
+#       define EVE_BOOT_POLL_MIN_US     1000
+#endif
+
+#ifndef EVE_BOOT_POLL_MAX_US
+#       define EVE_BOOT_POLL_MAX_US     16000
+#endif
+
+#ifndef EVE_BOOT_TIMEOUT_US
+#       define EVE_BOOT_TIMEOUT_US      300000
+#endif
+
+#ifndef EVE_BOOT_RETRIES
+#       define EVE_BOOT_RETRIES         3
+#endif
+
+/*
+ * Polling interval range in microseconds of the wait functions when there
+ * is no interrupt to wait on. The platform may spin the first short ones,
+ * longer ones block for at least a scheduler tick (EVE_ESP32_SPIN_MAX_US).
+ */
+#ifndef EVE_WAIT_POLL_MIN_US
+#       define EVE_WAIT_POLL_MIN_US     100
+#endif
+
+#ifndef EVE_WAIT_POLL_MAX_US
+#       define EVE_WAIT_POLL_MAX_US     4000
+#endif
+
 /*
  * Opaque configuration detailed individually in platform code.
  */
@@ -237,15 +684,52 @@ eve_init(const struct eve_cfg *cfg);
 int
 eve_power(intptr_t devc, int enable);
 
-#if 0
+/**
+ * Switch the SPI link to 1, 2 or 4 data lines through EVE_REG_SPI_WIDTH.
+ *
+ * The link is verified after the switch and reverted to a single line if
+ * the device can't be read back, in which case -1 is returned. The width
+ * goes back to a single line on power down and EVE_CMD_RST_PULSE.
+ */
+int
+eve_set_width(intptr_t devc, int width);
+
+/*
+ * Timeout value for the wait functions to block indefinitely.
+ */
+#define EVE_WAIT_FOREVER                UINT32_MAX
 
 /**
- * Send a download list command.
+ * Select the interrupts (EVE_IRQ_*) routed to the INT pin, 0 disables it.
+ *
+ * Returns -1 if the platform has no interrupt line configured.
  */
 int
-eve_dl(intptr_t devc, uint32_t data);
+eve_irq_enable(intptr_t devc, uint8_t mask);
 
-#endif
+/**
+ * Wait for any interrupt in mask, consuming it.
+ *
+ * Returns the interrupts of mask that fired, 0 on timeout or -1 if the
+ * platform has no interrupt line configured.
+ */
+int
+eve_irq_wait(intptr_t devc, uint8_t mask, uint32_t timeout_ms);
+
+/**
+ * Wait until the display list swap requested through EVE_REG_DLSWAP is done.
+ *
+ * Like eve_wait_cmdempty, returns -1 once timeout_ms elapsed. Without an
+ * interrupt line the register is polled with a growing interval.
+ */
+int
+eve_wait_swap(intptr_t devc, uint32_t timeout_ms);
+
+/**
+ * Wait until the coprocessor has consumed the whole command FIFO.
+ */
+int
+eve_wait_cmdempty(intptr_t devc, uint32_t timeout_ms);
 
 /**
  * Send a host command.
@@ -271,6 +755,505 @@ eve_write16(intptr_t devc, uint32_t address, uint16_t value);
 int
 eve_write32(intptr_t devc, uint32_t address, uint32_t value);
 
+/**
+ * Read size bytes starting at address in a single burst transaction.
+ */
+int
+eve_read(intptr_t devc, uint32_t address, void *data, size_t size);
+
+/**
+ * Write size bytes starting at address in a single burst transaction.
+ *
+ * Writing to EVE_REG_CMDB_WRITE appends every byte to the coprocessor FIFO
+ * without incrementing the address.
+ */
+int
+eve_write(intptr_t devc, uint32_t address, const void *data, size_t size);
+
+/**
+ * Completion callback for asynchronous transfers, status is 0 on success.
+ *
+ * It is invoked from the task that reaps the transfer (eve_async_poll,
+ * eve_async_wait or any synchronous function) and never from an interrupt.
+ */
+typedef void (*eve_async_cb_t)(void *arg, int status);
+
+/**
+ * Queue a write of size bytes at address and return immediately.
+ *
+ * The data must stay valid and unmodified until the callback is invoked and
+ * should live in DMA capable memory to avoid a bounce copy. Transfers larger
+ * than the bus limit are split, the callback is only called once everything
+ * has been sent. Synchronous functions wait for pending transfers first.
+ *
+ * The callback runs exactly once, also when -1 is returned: with status -1
+ * if any part could not be sent, after the last part queued has completed.
+ */
+int
+eve_write_async(intptr_t devc,
+                uint32_t address,
+                const void *data,
+                size_t size,
+                eve_async_cb_t cb,
+                void *arg);
+
+/**
+ * Reap completed asynchronous transfers without blocking.
+ *
+ * Returns the number of transfers still in flight.
+ */
+int
+eve_async_poll(intptr_t devc);
+
+/**
+ * Wait until every asynchronous transfer has completed.
+ */
+int
+eve_async_wait(intptr_t devc);
+
+/**
+ * Keep other tasks off the device for a sequence of accesses, they block on
+ * their next one until eve_unlock. Calls nest. Nothing waiting on interrupts
+ * may be called meanwhile, the interrupt task needs the lock too.
+ */
+void
+eve_lock(intptr_t devc);
+
+void
+eve_unlock(intptr_t devc);
+
+/*
+ * Register shadow.
+ *
+ * Registers only the host writes (display timings, backlight, GPIO, audio
+ * volumes, touch configuration) are mirrored per device: writing a value
+ * they already hold is skipped and reading them is served from memory once
+ * known. Every other register is considered volatile and always accessed.
+ * The list lives in eve.c.
+ *
+ * Power changes, host commands and writes to EVE_REG_CPURESET forget every
+ * value. Registers changed behind the shadow, through coprocessor commands
+ * such as CMD_MEMWRITE, require an explicit eve_shadow_invalidate.
+ */
+
+/* Number of shadowed registers. */
+#define EVE_SHADOW_REGS                 26
+
+struct eve_shadow_stats {
+	uint32_t hits;                  /* reads served from the shadow */
+	uint32_t misses;                /* shadowed reads sent to the device */
+	uint32_t elided;                /* writes skipped, value unchanged */
+};
+
+/**
+ * Forget every shadowed value, the next access goes to the device.
+ */
+void
+eve_shadow_invalidate(intptr_t devc);
+
+void
+eve_shadow_stats(intptr_t devc, struct eve_shadow_stats *stats);
+
+void
+eve_shadow_stats_reset(intptr_t devc);
+
+struct eve;
+
+/*
+ * Transport and device control implemented by a platform, every function
+ * above dispatches through it. Optional entries may be left NULL:
+ *
+ * - write_async: eve_write_async falls back to a synchronous write and calls
+ *   the callback before returning.
+ * - async_poll, async_wait: nothing is ever in flight.
+ * - set_width: only a single line link is supported.
+ * - irq_enable, irq_wait: no interrupt line, waits fall back to polling.
+ * - lock, unlock: the device is only used from one task. Otherwise they must
+ *   be recursive as the generic layer holds the lock around read and write
+ *   and around whole coprocessor sequences.
+ *
+ * time (monotonic microseconds) and sleep are required, the wait functions
+ * rely on them when there is no interrupt to wait on.
+ */
+struct eve_ops {
+	int (*read)(struct eve *eve, uint32_t address, void *data, size_t size);
+	int (*write)(struct eve *eve, uint32_t address, const void *data, size_t size);
+	int (*write_async)(struct eve *eve,
+	                   uint32_t address,
+	                   const void *data,
+	                   size_t size,
+	                   eve_async_cb_t cb,
+	                   void *arg);
+	int (*async_poll)(struct eve *eve);
+	int (*async_wait)(struct eve *eve);
+	int (*cmd)(struct eve *eve, uint8_t cmd, uint8_t param);
+	int (*power)(struct eve *eve, int enable);
+	int (*set_width)(struct eve *eve, int width);
+	int (*irq_enable)(struct eve *eve, uint8_t mask);
+	int (*irq_wait)(struct eve *eve, uint8_t mask, uint32_t timeout_ms);
+	void (*lock)(struct eve *eve);
+	void (*unlock)(struct eve *eve);
+	int64_t (*time)(struct eve *eve);
+	void (*sleep)(struct eve *eve, uint32_t us);
+	void (*finish)(struct eve *eve);
+};
+
+/*
+ * Common head of every platform device, eve_init returns its address as the
+ * intptr_t handle so platforms must place it first in their own structure
+ * and zero it before setting ops.
+ */
+struct eve {
+	const struct eve_ops *ops;
+	uint32_t shadow_valid;          /* one bit per shadowed register */
+	uint8_t shadow[EVE_SHADOW_REGS][4];  /* little endian, reserved bytes 0 */
+	struct eve_shadow_stats shadow_stats;
+};
+
+enum eve_boot_state {
+	EVE_BOOT_POWER_OFF,             /* PD held low */
+	EVE_BOOT_POWER_ON,              /* PD high, waiting to activate */
+	EVE_BOOT_WAIT_ID,               /* polling REG_ID */
+	EVE_BOOT_WAIT_RESET,            /* polling REG_CPURESET */
+	EVE_BOOT_DONE,
+	EVE_BOOT_FAILED,
+	EVE_BOOT_NSTATES
+};
+
+/*
+ * Non blocking boot sequence.
+ *
+ * The caller owns the clock and the waiting: eve_boot_step performs at most
+ * one bus operation and tells how long to wait before calling it again, so
+ * booting can be interleaved with other work. The time at which each state
+ * was entered is recorded in stamps, relative to the start of the sequence.
+ */
+struct eve_boot {
+	intptr_t devc;
+	enum eve_boot_state state;
+	unsigned int retries;
+	int64_t start;
+	int64_t deadline;
+	int64_t backoff;
+	int64_t stamps[EVE_BOOT_NSTATES];
+};
+
+/**
+ * Power the device off and start the sequence at now_us.
+ *
+ * Returns the delay in microseconds before the first eve_boot_step.
+ */
+int64_t
+eve_boot_init(struct eve_boot *boot, intptr_t devc, int64_t now_us);
+
+/**
+ * Advance the sequence.
+ *
+ * Returns the delay in microseconds before the next call or 0 once the
+ * state is EVE_BOOT_DONE or EVE_BOOT_FAILED.
+ */
+int64_t
+eve_boot_step(struct eve_boot *boot, int64_t now_us);
+
+/*
+ * Register assignment for eve_writev.
+ */
+struct eve_reg {
+	uint32_t address;
+	uint32_t value;
+};
+
+/**
+ * Write several 32-bit registers at once.
+ *
+ * The array is sorted in place by address and registers that occupy adjacent
+ * 4-byte slots are merged into a single burst, so writing a contiguous block
+ * costs one transfer. Addresses must be 4-byte aligned and unique.
+ */
+int
+eve_writev(intptr_t devc, struct eve_reg *regs, size_t n);
+
+/**
+ * Read n consecutive 32-bit registers starting at address in one burst.
+ */
+int
+eve_readv(intptr_t devc, uint32_t address, uint32_t *values, size_t n);
+
+/*
+ * Coprocessor command staging buffer.
+ *
+ * Commands are appended into buf and sent to EVE_REG_CMDB_WRITE in one burst
+ * when the buffer is full or when eve_cp_flush is called, the free space
+ * in the FIFO is only checked once per flush unless the coprocessor is
+ * lagging behind.
+ *
+ * The device lock is held for the whole of each flush, eve_cp_stream and
+ * eve_cp_send: commands from other tasks are never interleaved with a
+ * partially written one. The FIFO is polled for space meanwhile, not waited
+ * on through the interrupt.
+ */
+struct eve_cp {
+	intptr_t devc;
+	size_t len;
+	uint32_t buf[EVE_CP_BUF_MAX];
+};
+
+/**
+ * Initialize the staging buffer for the given device.
+ */
+void
+eve_cp_init(struct eve_cp *cp, intptr_t devc);
+
+/**
+ * Append a command word, flushing first if the buffer is full.
+ */
+int
+eve_cp_push(struct eve_cp *cp, uint32_t word);
+
+/**
+ * Append arbitrary data padded to a multiple of 4 bytes.
+ */
+int
+eve_cp_push_data(struct eve_cp *cp, const void *data, size_t size);
+
+/**
+ * Append a NUL terminated string padded to a multiple of 4 bytes.
+ */
+int
+eve_cp_push_string(struct eve_cp *cp, const char *str);
+
+/**
+ * Stream data to the coprocessor directly from the caller memory.
+ *
+ * Pending words are flushed first, then data is written to
+ * EVE_REG_CMDB_WRITE in bursts as large as the free FIFO space without
+ * going through the staging buffer. The tail is zero padded to a multiple
+ * of 4 bytes.
+ */
+int
+eve_cp_stream(struct eve_cp *cp, const void *data, size_t size);
+
+/**
+ * Send every pending word to the coprocessor.
+ */
+int
+eve_cp_flush(struct eve_cp *cp);
+
+/**
+ * Send n pre-encoded words straight to the coprocessor, bypassing any
+ * staging buffer.
+ *
+ * Meant for constant command streams kept in flash: a static list wrapped in
+ * EVE_CPC_DLSTART and EVE_CPC_SWAP is shown with a single burst if the FIFO
+ * has room for it, there is no encoding nor copy on the host.
+ */
+int
+eve_cp_send(intptr_t devc, const uint32_t *words, size_t n);
+
+/**
+ * Flush and wait until the coprocessor has consumed the whole FIFO.
+ */
+int
+eve_cp_wait(struct eve_cp *cp);
+
+int
+eve_cp_dlstart(struct eve_cp *cp);
+
+int
+eve_cp_swap(struct eve_cp *cp);
+
+int
+eve_cp_memwrite(struct eve_cp *cp, uint32_t ptr, const void *data, size_t size);
+
+int
+eve_cp_memcpy(struct eve_cp *cp, uint32_t dest, uint32_t src, uint32_t num);
+
+int
+eve_cp_memset(struct eve_cp *cp, uint32_t ptr, uint8_t value, uint32_t num);
+
+int
+eve_cp_memzero(struct eve_cp *cp, uint32_t ptr, uint32_t num);
+
+int
+eve_cp_append(struct eve_cp *cp, uint32_t ptr, uint32_t num);
+
+/**
+ * Start a CMD_INFLATE, the zlib stream must follow (see eve_cp_stream).
+ */
+int
+eve_cp_inflate(struct eve_cp *cp, uint32_t ptr);
+
+/**
+ * Start a CMD_LOADIMAGE, the PNG/JPEG data must follow.
+ */
+int
+eve_cp_loadimage(struct eve_cp *cp, uint32_t ptr, uint32_t options);
+
+int
+eve_cp_text(struct eve_cp *cp, int16_t x, int16_t y, int16_t font, uint16_t options, const char *str);
+
+/*
+ * Display list builder.
+ *
+ * Commands are encoded into buf and uploaded to EVE_MAP_RAM_DL in a single
+ * burst. The helpers never fail individually, if the list grows beyond
+ * RAM_DL the overflow flag is set and the upload is refused.
+ */
+struct eve_dl {
+	size_t len;
+	int overflow;
+	uint32_t buf[EVE_DL_MAX];
+};
+
+/**
+ * Reset the display list to empty.
+ */
+void
+eve_dl_init(struct eve_dl *dl);
+
+/**
+ * Append a raw display list command.
+ */
+int
+eve_dl_push(struct eve_dl *dl, uint32_t word);
+
+/**
+ * Append n pre-encoded words, such as a static list of EVE_DL_* commands for
+ * the fixed parts of the screen.
+ */
+int
+eve_dl_append(struct eve_dl *dl, const uint32_t *words, size_t n);
+
+void
+eve_dl_display(struct eve_dl *dl);
+
+void
+eve_dl_begin(struct eve_dl *dl, uint32_t prim);
+
+void
+eve_dl_end(struct eve_dl *dl);
+
+void
+eve_dl_clear(struct eve_dl *dl, uint32_t flags);
+
+void
+eve_dl_clear_color_rgb(struct eve_dl *dl, uint8_t r, uint8_t g, uint8_t b);
+
+void
+eve_dl_clear_color_a(struct eve_dl *dl, uint8_t a);
+
+void
+eve_dl_color_rgb(struct eve_dl *dl, uint8_t r, uint8_t g, uint8_t b);
+
+void
+eve_dl_color_a(struct eve_dl *dl, uint8_t a);
+
+void
+eve_dl_point_size(struct eve_dl *dl, uint16_t size);
+
+void
+eve_dl_line_width(struct eve_dl *dl, uint16_t width);
+
+void
+eve_dl_tag(struct eve_dl *dl, uint8_t tag);
+
+void
+eve_dl_tag_mask(struct eve_dl *dl, int enable);
+
+void
+eve_dl_scissor_xy(struct eve_dl *dl, uint16_t x, uint16_t y);
+
+void
+eve_dl_scissor_size(struct eve_dl *dl, uint16_t width, uint16_t height);
+
+void
+eve_dl_save_context(struct eve_dl *dl);
+
+void
+eve_dl_restore_context(struct eve_dl *dl);
+
+void
+eve_dl_vertex_format(struct eve_dl *dl, uint8_t frac);
+
+void
+eve_dl_bitmap_handle(struct eve_dl *dl, uint8_t handle);
+
+void
+eve_dl_bitmap_source(struct eve_dl *dl, uint32_t address);
+
+/**
+ * Set BITMAP_LAYOUT and BITMAP_LAYOUT_H for the given stride and height.
+ */
+void
+eve_dl_bitmap_layout(struct eve_dl *dl, uint8_t format, uint16_t stride, uint16_t height);
+
+/**
+ * Set BITMAP_SIZE and BITMAP_SIZE_H for the given dimensions.
+ */
+void
+eve_dl_bitmap_size(struct eve_dl *dl, uint8_t filter, uint8_t wrapx, uint8_t wrapy, uint16_t width, uint16_t height);
+
+void
+eve_dl_bitmap_ext_format(struct eve_dl *dl, uint16_t format);
+
+void
+eve_dl_cell(struct eve_dl *dl, uint8_t cell);
+
+/**
+ * Vertex in 1/16 pixel units unless changed with eve_dl_vertex_format.
+ */
+void
+eve_dl_vertex2f(struct eve_dl *dl, int16_t x, int16_t y);
+
+void
+eve_dl_vertex2ii(struct eve_dl *dl, uint16_t x, uint16_t y, uint8_t handle, uint8_t cell);
+
+/**
+ * Upload the whole display list to EVE_MAP_RAM_DL in one burst.
+ */
+int
+eve_dl_upload(intptr_t devc, const struct eve_dl *dl);
+
+/**
+ * Upload the display list and request a swap at the next frame.
+ */
+int
+eve_dl_swap(intptr_t devc, const struct eve_dl *dl);
+
+/*
+ * Copy of what the host wrote into RAM_DL, used by eve_dl_swap_delta.
+ *
+ * RAM_DL is double buffered: after a swap the host writes into the buffer
+ * that was displayed until then, which still holds the list uploaded two
+ * swaps ago. One copy per buffer is therefore kept and the new list is
+ * compared against the one that will actually be overwritten.
+ */
+struct eve_dl_shadow {
+	unsigned int index;
+	size_t len[2];
+	uint32_t buf[2][EVE_DL_MAX];
+
+	/* Bytes a full upload would have sent versus bytes really sent. */
+	uint64_t bytes_full;
+	uint64_t bytes_sent;
+};
+
+/**
+ * Forget the RAM_DL content, next two swaps will upload the whole list.
+ *
+ * Must also be called whenever RAM_DL is written by other means (coprocessor
+ * CMD_SWAP, eve_dl_swap, device reset).
+ */
+void
+eve_dl_shadow_init(struct eve_dl_shadow *shadow);
+
+/**
+ * Like eve_dl_swap but only write the words that differ from the list
+ * previously uploaded in the same RAM_DL buffer.
+ */
+int
+eve_dl_swap_delta(intptr_t devc, struct eve_dl_shadow *shadow, const struct eve_dl *dl);
+
 /**
  * Dispose resource.
  */
@@ -0,0 +1,149 @@
+#if defined(EVE_ESP32)
+
+#include <assert.h>
+#include <string.h>
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+
+#include "eve.h"
+#include "eve_asset.h"
+
+#define TAG "eve"
+
+/*
+ * Amount of data streamed per coprocessor write, keeps the bounce buffer the
+ * SPI driver needs for flash mapped memory small.
+ */
+#define CHUNK 1024
+
+struct header {
+	char magic[4];
+	uint32_t version;
+	uint32_t count;
+};
+
+int
+eve_asset_open(struct eve_asset_pack *pack, const char *label)
+{
+	assert(pack);
+	assert(label);
+
+	const esp_partition_t *part;
+	const struct header *hdr;
+	const void *ptr;
+	esp_partition_mmap_handle_t handle;
+	esp_err_t err;
+
+	memset(pack, 0, sizeof (*pack));
+
+	part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+
+	if (!part) {
+		ESP_LOGW(TAG, "asset partition %s not found", label);
+		return -1;
+	}
+
+	if ((err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &handle)) != ESP_OK) {
+		ESP_LOGW(TAG, "unable to map partition %s: %s", label, esp_err_to_name(err));
+		return -1;
+	}
+
+	hdr = ptr;
+
+	if (memcmp(hdr->magic, EVE_ASSET_MAGIC, 4) != 0 ||
+	    hdr->version != EVE_ASSET_VERSION ||
+	    sizeof (*hdr) + (uint64_t)hdr->count * sizeof (struct eve_asset_entry) > part->size) {
+		ESP_LOGW(TAG, "partition %s has no valid asset index", label);
+		esp_partition_munmap(handle);
+		return -1;
+	}
+
+	pack->base    = ptr;
+	pack->size    = part->size;
+	pack->count   = hdr->count;
+	pack->entries = (const struct eve_asset_entry *)(hdr + 1);
+	pack->handle  = handle;
+
+	ESP_LOGI(TAG, "asset partition %s: %u asset(s)", label, (unsigned int)pack->count);
+
+	return 0;
+}
+
+const struct eve_asset_entry *
+eve_asset_find(const struct eve_asset_pack *pack, const char *name)
+{
+	assert(pack);
+	assert(name);
+
+	for (uint32_t i = 0; i < pack->count; ++i)
+		if (strncmp(pack->entries[i].name, name, EVE_ASSET_NAME_MAX) == 0)
+			return &pack->entries[i];
+
+	return NULL;
+}
+
+int
+eve_asset_load(const struct eve_asset_pack *pack,
+               const struct eve_asset_entry *entry,
+               struct eve_cp *cp,
+               uint32_t dest,
+               uint32_t options)
+{
+	assert(pack);
+	assert(entry);
+	assert(cp);
+
+	const uint8_t *data;
+	size_t size, n;
+	int rc = 0;
+
+	if ((uint64_t)entry->offset + entry->size > pack->size) {
+		ESP_LOGW(TAG, "asset %.*s out of partition", EVE_ASSET_NAME_MAX, entry->name);
+		return -1;
+	}
+
+	data = pack->base + entry->offset;
+	size = entry->size;
+
+	switch (entry->type) {
+	case EVE_ASSET_RAW:
+		rc = eve_cp_push(cp, EVE_CPC_MEMWRITE) < 0 ||
+		     eve_cp_push(cp, dest) < 0 ||
+		     eve_cp_push(cp, size) < 0 ? -1 : 0;
+		break;
+	case EVE_ASSET_DEFLATE:
+		rc = eve_cp_inflate(cp, dest);
+		break;
+	case EVE_ASSET_IMAGE:
+		rc = eve_cp_loadimage(cp, dest, options);
+		break;
+	default:
+		ESP_LOGW(TAG, "asset %.*s has unknown type", EVE_ASSET_NAME_MAX, entry->name);
+		return -1;
+	}
+
+	for (; rc == 0 && size; data += n, size -= n) {
+		n = size < CHUNK ? size : CHUNK;
+		rc = eve_cp_stream(cp, data, n);
+	}
+
+	if (rc < 0)
+		ESP_LOGW(TAG, "unable to load asset %.*s", EVE_ASSET_NAME_MAX, entry->name);
+
+	return rc;
+}
+
+void
+eve_asset_close(struct eve_asset_pack *pack)
+{
+	assert(pack);
+
+	if (pack->base)
+		esp_partition_munmap(pack->handle);
+
+	memset(pack, 0, sizeof (*pack));
+}
+
+#endif /* !EVE_ESP32 */
@@ -0,0 +1,78 @@
+#ifndef EVE_ASSET_H
+#define EVE_ASSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Assets packed in a flash partition by tools/evepack.py.
+ *
+ * The partition is memory mapped and every asset is streamed from the
+ * mapping straight into the coprocessor FIFO, only a constant amount of
+ * host RAM is used whatever the asset size.
+ *
+ * Layout (little endian):
+ *
+ *   header  "EVEA", version, count
+ *   entries count * struct eve_asset_entry
+ *   data    each asset 4-byte aligned at entry offset
+ */
+
+struct eve_cp;
+
+#define EVE_ASSET_MAGIC                 "EVEA"
+#define EVE_ASSET_VERSION               1
+#define EVE_ASSET_NAME_MAX              24
+
+enum eve_asset_type {
+	EVE_ASSET_RAW,                  /* copied as is */
+	EVE_ASSET_DEFLATE,              /* zlib stream, CMD_INFLATE */
+	EVE_ASSET_IMAGE                 /* PNG or JPEG, CMD_LOADIMAGE */
+};
+
+struct eve_asset_entry {
+	char name[EVE_ASSET_NAME_MAX];
+	uint32_t offset;
+	uint32_t size;                  /* bytes in the partition */
+	uint32_t raw_size;              /* bytes in RAM_G once loaded, at most */
+	uint32_t type;
+};
+
+struct eve_asset_pack {
+	const uint8_t *base;
+	size_t size;
+	uint32_t count;
+	const struct eve_asset_entry *entries;
+	uint32_t handle;
+};
+
+/**
+ * Map the data partition with the given label.
+ */
+int
+eve_asset_open(struct eve_asset_pack *pack, const char *label);
+
+/**
+ * Find an asset by name, returns NULL if not found.
+ */
+const struct eve_asset_entry *
+eve_asset_find(const struct eve_asset_pack *pack, const char *name);
+
+/**
+ * Load the asset into RAM_G at dest through the coprocessor.
+ *
+ * Options are passed to CMD_LOADIMAGE for images and ignored otherwise. The
+ * function returns once everything is in the FIFO, use eve_cp_wait to make
+ * sure the coprocessor is done with it.
+ */
+int
+eve_asset_load(const struct eve_asset_pack *pack,
+               const struct eve_asset_entry *entry,
+               struct eve_cp *cp,
+               uint32_t dest,
+               uint32_t options);
+
+void
+eve_asset_close(struct eve_asset_pack *pack);
+
+#endif /* !EVE_ASSET_H */
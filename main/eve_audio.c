@@ -0,0 +1,239 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_audio.h"
+
+#define RAM_G_SIZE      (1024U * 1024U)
+
+/* READPTR and the other addresses are 20 bits wide. */
+#define ADDR_MASK       0xfffffU
+
+static uint8_t
+silence(uint8_t format)
+{
+	switch (format) {
+	case EVE_SAMPLES_ULAW:
+		return 0xff;
+	case EVE_SAMPLES_ADPCM:
+		/* Opposite zero steps, the decoder output doesn't drift. */
+		return 0x80;
+	default:
+		return 0x00;
+	}
+}
+
+static void
+chunk_done(void *arg, int status)
+{
+	struct eve_audio_chunk *chunk = arg;
+
+	chunk->busy = 0;
+
+	if (status < 0)
+		chunk->audio->failed = 1;
+}
+
+/*
+ * Write one half of the ring, from the producer until it runs dry and with
+ * silence then.
+ */
+static int
+refill(struct eve_audio *audio, uint8_t half)
+{
+	uint32_t address = audio->base + half * audio->half;
+	struct eve_audio_chunk *chunk;
+	size_t n, got;
+	int i = 0;
+
+	audio->failed = 0;
+
+	for (uint32_t off = 0; off < audio->half; off += n) {
+		n = audio->half - off < EVE_AUDIO_CHUNK ? audio->half - off : EVE_AUDIO_CHUNK;
+		chunk = &audio->chunks[i++ % 2];
+
+		/* Sent two chunks ago, normally done by now. */
+		while (chunk->busy)
+			eve_async_poll(audio->devc);
+
+		got = audio->ending ? 0 : audio->fill(audio->arg, chunk->buf, n);
+
+		if (got < n) {
+			memset(chunk->buf + got, silence(audio->format), n - got);
+
+			if (!audio->ending) {
+				audio->ending = 1;
+				audio->end = half;
+			}
+		}
+
+		/* The callback runs even on failure, the chunk is released. */
+		chunk->busy = 1;
+
+		if (eve_write_async(audio->devc, address + off, chunk->buf, n, chunk_done, chunk) < 0)
+			break;
+
+		audio->stats.bytes += got;
+	}
+
+	/* The ring must be complete before the device plays it. */
+	eve_async_wait(audio->devc);
+
+	if (audio->failed) {
+		audio->stats.errors++;
+		return -1;
+	}
+
+	audio->stats.refills++;
+
+	return 0;
+}
+
+/*
+ * Time taken to play half of the ring.
+ */
+static int64_t
+half_us(const struct eve_audio *audio)
+{
+	uint32_t rate = audio->format == EVE_SAMPLES_ADPCM ? audio->freq / 2 : audio->freq;
+
+	return rate ? (int64_t)audio->half * 1000000 / rate : 0;
+}
+
+static int64_t
+poll_us(const struct eve_audio *audio)
+{
+	int64_t delay = half_us(audio) / 2;
+
+	return delay && delay < EVE_AUDIO_POLL_US ? delay : EVE_AUDIO_POLL_US;
+}
+
+int
+eve_audio_init(struct eve_audio *audio,
+               intptr_t devc,
+               uint32_t base,
+               uint32_t size,
+               eve_audio_fill_t fill,
+               void *arg)
+{
+	assert(audio);
+	assert(fill);
+
+	/* Each half must be a multiple of the 8 bytes playback unit. */
+	if (base % 16 || size % 16 || !size || base > RAM_G_SIZE || size > RAM_G_SIZE - base)
+		return -1;
+
+	memset(audio, 0, offsetof(struct eve_audio, chunks));
+	audio->devc = devc;
+	audio->fill = fill;
+	audio->arg = arg;
+	audio->base = base;
+	audio->half = size / 2;
+
+	for (size_t i = 0; i < 2; ++i) {
+		audio->chunks[i].audio = audio;
+		audio->chunks[i].busy = 0;
+	}
+
+	return 0;
+}
+
+int
+eve_audio_play(struct eve_audio *audio, uint8_t format, uint16_t freq, int64_t now_us)
+{
+	assert(audio);
+
+	struct eve_reg regs[] = {
+		{ EVE_REG_PLAYBACK_START,  audio->base     },
+		{ EVE_REG_PLAYBACK_LENGTH, audio->half * 2 },
+		{ EVE_REG_PLAYBACK_FREQ,   freq            },
+		{ EVE_REG_PLAYBACK_FORMAT, format          },
+		{ EVE_REG_PLAYBACK_LOOP,   1               },
+	};
+
+	if (audio->playing && eve_audio_stop(audio) < 0)
+		return -1;
+
+	audio->format = format;
+	audio->freq = freq;
+	audio->ending = 0;
+	audio->reading = 0;
+	audio->dirty = 0;
+	audio->stepped = now_us;
+
+	if (refill(audio, 0) < 0 || refill(audio, 1) < 0)
+		return -1;
+
+	/* PLAY last, the other registers are latched when it is set. */
+	if (eve_writev(audio->devc, regs, sizeof (regs) / sizeof (regs[0])) < 0 ||
+	    eve_write8(audio->devc, EVE_REG_PLAYBACK_PLAY, 1) < 0)
+		return -1;
+
+	audio->playing = 1;
+
+	return 0;
+}
+
+int64_t
+eve_audio_step(struct eve_audio *audio, int64_t now_us)
+{
+	assert(audio);
+
+	uint32_t ptr;
+	uint8_t half, other;
+
+	if (!audio->playing)
+		return 0;
+
+	/*
+	 * READPTR can't tell how many times the ring went round, a whole half
+	 * was played since the last step without a chance to refill it.
+	 */
+	if (now_us - audio->stepped > half_us(audio))
+		audio->stats.underruns++;
+
+	audio->stepped = now_us;
+
+	if (eve_read32(audio->devc, EVE_REG_PLAYBACK_READPTR, &ptr) < 0)
+		return poll_us(audio);
+
+	half = ((ptr - audio->base) & ADDR_MASK) >= audio->half;
+	other = half ^ 1;
+
+	if (half != audio->reading) {
+		/* The last samples are out, what follows is silence. */
+		if (audio->ending && audio->reading == audio->end) {
+			eve_audio_stop(audio);
+			return 0;
+		}
+
+		audio->dirty |= 1 << audio->reading;
+		audio->reading = half;
+	}
+
+	/* Too late for this one, it is played as it is. */
+	if (audio->dirty & (1 << half)) {
+		audio->dirty &= ~(1 << half);
+		audio->stats.underruns++;
+	}
+
+	if (audio->dirty & (1 << other) && refill(audio, other) == 0)
+		audio->dirty &= ~(1 << other);
+
+	return poll_us(audio);
+}
+
+int
+eve_audio_stop(struct eve_audio *audio)
+{
+	assert(audio);
+
+	audio->playing = 0;
+
+	/* A zero length playback is how the device is told to stop. */
+	if (eve_write32(audio->devc, EVE_REG_PLAYBACK_LENGTH, 0) < 0 ||
+	    eve_write8(audio->devc, EVE_REG_PLAYBACK_PLAY, 1) < 0)
+		return -1;
+
+	return 0;
+}
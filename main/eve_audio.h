@@ -0,0 +1,117 @@
+#ifndef EVE_AUDIO_H
+#define EVE_AUDIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Streaming audio playback.
+ *
+ * Samples go to a ring in RAM_G played in loop mode. The ring is split in
+ * two halves: while the device plays one of them the host refills the
+ * other, found from REG_PLAYBACK_READPTR. Refills are written in chunks of
+ * EVE_AUDIO_CHUNK bytes, each one a burst of its own, so the bus is never
+ * held long enough to delay a frame upload. Chunks are double buffered and
+ * queued with eve_write_async: the producer fills one while the other is on
+ * the bus. A refill returns once all of its chunks completed, the structure
+ * should live in DMA capable memory.
+ *
+ * Samples come from a producer callback, a flash partition reader or a
+ * decoder. Once it runs dry the rest of the ring is filled with silence and
+ * playback stops after the last samples were played.
+ *
+ * Like eve_frame the caller owns the clock and the waiting: eve_audio_step
+ * refills what is due at now_us and tells how long to sleep. Steps must be
+ * at most half a ring apart, otherwise the device plays stale samples and
+ * an underrun is counted.
+ */
+
+/*
+ * Bytes per refill burst.
+ */
+#ifndef EVE_AUDIO_CHUNK
+#       define EVE_AUDIO_CHUNK          1024
+#endif
+
+/*
+ * Longest delay returned while playing, in microseconds.
+ */
+#ifndef EVE_AUDIO_POLL_US
+#       define EVE_AUDIO_POLL_US        20000
+#endif
+
+/**
+ * Store up to size bytes of samples in buf.
+ *
+ * Returns the number of bytes stored, less than size at the end of the
+ * stream.
+ */
+typedef size_t (*eve_audio_fill_t)(void *arg, void *buf, size_t size);
+
+struct eve_audio_stats {
+	uint32_t refills;               /* halves written */
+	uint32_t underruns;             /* halves played before being refilled */
+	uint32_t errors;                /* failed refills, retried */
+	uint64_t bytes;                 /* samples from the producer */
+};
+
+struct eve_audio_chunk {
+	struct eve_audio *audio;
+	int busy;                       /* queued, not completed */
+	uint8_t buf[EVE_AUDIO_CHUNK];
+};
+
+struct eve_audio {
+	intptr_t devc;
+	eve_audio_fill_t fill;
+	void *arg;
+	uint32_t base;                  /* ring address in RAM_G */
+	uint32_t half;                  /* bytes */
+	uint16_t freq;
+	uint8_t format;                 /* EVE_SAMPLES_* */
+	int playing;
+	int ending;                     /* producer ran dry */
+	uint8_t end;                    /* half holding the last samples */
+	uint8_t reading;                /* half played at the last step */
+	uint8_t dirty;                  /* mask of halves to refill */
+	int64_t stepped;                /* last step */
+	int failed;                     /* a chunk of the refill was lost */
+	struct eve_audio_stats stats;
+	struct eve_audio_chunk chunks[2];
+};
+
+/**
+ * Use size bytes of RAM_G at base as ring, both multiples of 16.
+ */
+int
+eve_audio_init(struct eve_audio *audio,
+               intptr_t devc,
+               uint32_t base,
+               uint32_t size,
+               eve_audio_fill_t fill,
+               void *arg);
+
+/**
+ * Fill the ring and start playing samples in the given format at freq Hz,
+ * playback in progress is restarted.
+ */
+int
+eve_audio_play(struct eve_audio *audio, uint8_t format, uint16_t freq, int64_t now_us);
+
+/**
+ * Refill the half not being played if needed and stop once the stream is
+ * over.
+ *
+ * Returns the delay in microseconds before the next call or 0 when not
+ * playing.
+ */
+int64_t
+eve_audio_step(struct eve_audio *audio, int64_t now_us);
+
+/**
+ * Stop playback right away.
+ */
+int
+eve_audio_stop(struct eve_audio *audio);
+
+#endif /* !EVE_AUDIO_H */
@@ -1,7 +1,21 @@
 #if defined(EVE_ESP32)
 
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_attr.h>
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <soc/soc_caps.h>
 
 #include <endian.h>
 
@@ -10,29 +24,180 @@
 
 #define TAG       "eve"
 #define DEVC(s)   ((struct devc *)(s))
+#define EVE(s)    (&(s)->eve)
+
+/*
+ * Transaction flags for the current link width, the BT81x expects the
+ * address on the same lines as the data.
+ */
+#define WIDTH(devc)                                                     \
+	((devc)->width == 4 ? SPI_TRANS_MODE_QIO | SPI_TRANS_MULTILINE_ADDR : \
+	 (devc)->width == 2 ? SPI_TRANS_MODE_DIO | SPI_TRANS_MULTILINE_ADDR : 0)
 
+/*
+ * Instrumentation, everything compiles away unless EVE_ESP32_STATS is set.
+ */
+#if defined(EVE_ESP32_STATS)
+#       define STAT_NOW()                      esp_timer_get_time()
+#       define STAT_ADD(devc, field, n)        ((devc)->stats.field += (n))
+#       define STAT_OP(devc, op, start)        eve__stat_op(devc, op, start)
+#else
+#       define STAT_NOW()                      0
+#       define STAT_ADD(devc, field, n)        ((void)(n))
+#       define STAT_OP(devc, op, start)        ((void)(start))
+#endif
+
+/*
+ * CS is only asserted once the bus is ours and deasserted before giving it
+ * back, otherwise a transaction to another device on the same bus would be
+ * seen by this one too.
+ */
 #define ACQUIRE(devc) do {                                              \
-	gpio_set_level((devc)->pin_cs, 0);                              \
+	int64_t acquire_ = STAT_NOW();                                  \
+	eve__async_drain(devc);                                         \
 	spi_device_acquire_bus((devc)->handle, portMAX_DELAY);          \
+	gpio_set_level((devc)->pin_cs, 0);                              \
+	STAT_ADD(devc, acquire_us, STAT_NOW() - acquire_);              \
 } while (0)
 
 #define RELEASE(devc) do {                                              \
-	spi_device_release_bus((devc)->handle);                         \
 	gpio_set_level((devc)->pin_cs, 1);                              \
+	spi_device_release_bus((devc)->handle);                         \
 } while (0)
 
+/*
+ * Every operation on a device holds its lock, it is recursive as operations
+ * are built on top of each other (width negotiation, interrupt task).
+ */
+#define LOCK(devc)      xSemaphoreTakeRecursive((devc)->lock, portMAX_DELAY)
+#define UNLOCK(devc)    xSemaphoreGiveRecursive((devc)->lock)
+
+struct devc;
+
+/*
+ * Queued asynchronous transaction, the address is sent in the address phase
+ * of the transaction itself so that data can be sent straight from the
+ * caller buffer. CS is driven from the pre/post transaction callbacks.
+ */
+struct async {
+	spi_transaction_ext_t tx;
+	struct devc *devc;
+	eve_async_cb_t cb;
+	void *arg;
+	int status;                     /* passed to cb, -1 if a chunk was lost */
+	int busy;
+	int64_t start;
+};
+
 /*
  * The automatic spics_io_num does not seem to work all the time so create our
  * own interface but for that we need to keep track of the CS pin ourselves as
  * we need to set spics_io_num to -1 to indicate IDF to not touch it.
  */
 struct devc {
+	struct eve eve;
 	spi_device_handle_t handle;
 	gpio_num_t pin_cs;
 	gpio_num_t pin_pd;
+	size_t xfer_size;
+	int width;
+	int width_max;
+	struct async *async;
+	size_t async_size;
+	size_t async_pending;
+	gpio_num_t pin_int;
+	TaskHandle_t irq_task;
+	EventGroupHandle_t irq_events;
+	size_t slice_size;
+	SemaphoreHandle_t lock;
+	int used;
+#if defined(EVE_ESP32_STATS)
+	struct eve_esp32_stats stats;
+#endif
 };
 
 static struct devc devices[EVE_ESP32_DEV_MAX];
+static portMUX_TYPE devices_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if defined(EVE_ESP32_STATS)
+
+static void
+eve__stat_op(struct devc *devc, enum eve_esp32_op op, int64_t start)
+{
+	int64_t us = esp_timer_get_time() - start;
+	int bucket = us > 0 ? 64 - __builtin_clzll(us) : 0;
+
+	if (bucket >= EVE_ESP32_HIST_MAX)
+		bucket = EVE_ESP32_HIST_MAX - 1;
+
+	devc->stats.hist[op][bucket]++;
+}
+
+#endif
+
+/*
+ * Polling transactions leave user to NULL so only queued ones toggle CS
+ * here, the synchronous functions keep CS low for the whole burst
+ * themselves.
+ */
+
+static void IRAM_ATTR
+eve__pre_cb(spi_transaction_t *t)
+{
+	const struct async *async = t->user;
+
+	if (async)
+		gpio_set_level(async->devc->pin_cs, 0);
+}
+
+static void IRAM_ATTR
+eve__post_cb(spi_transaction_t *t)
+{
+	const struct async *async = t->user;
+
+	if (async)
+		gpio_set_level(async->devc->pin_cs, 1);
+}
+
+static int
+eve__async_reap(struct devc *devc, TickType_t ticks)
+{
+	spi_transaction_t *t;
+	struct async *async;
+
+	if (spi_device_get_trans_result(devc->handle, &t, ticks) != ESP_OK)
+		return -1;
+
+	async = t->user;
+	async->busy = 0;
+	devc->async_pending--;
+	STAT_OP(devc, EVE_ESP32_OP_ASYNC, async->start);
+
+	if (async->cb)
+		async->cb(async->arg, async->status);
+
+	return 0;
+}
+
+static void
+eve__async_drain(struct devc *devc)
+{
+	while (devc->async_pending)
+		eve__async_reap(devc, portMAX_DELAY);
+}
+
+static struct async *
+eve__async_get(struct devc *devc)
+{
+	for (;;) {
+		for (size_t i = 0; i < devc->async_size; ++i)
+			if (!devc->async[i].busy)
+				return &devc->async[i];
+
+		/* All slots in flight, wait for the oldest one. */
+		eve__async_reap(devc, portMAX_DELAY);
+	}
+}
 
 int
 eve__open(struct devc *devc, const struct eve_cfg *cfg)
@@ -45,6 +210,9 @@ eve__open(struct devc *devc, const struct eve_cfg *cfg)
 	devc_cfg.clock_speed_hz = cfg->spi_clk_speed;
 	devc_cfg.spics_io_num   = -1;
 	devc_cfg.queue_size     = cfg->queue_size;
+	devc_cfg.pre_cb         = eve__pre_cb;
+	devc_cfg.post_cb        = eve__post_cb;
+	devc_cfg.flags          = cfg->spi_width > 1 ? SPI_DEVICE_HALFDUPLEX : 0;
 
 	gpio_cfg.pin_bit_mask   = BIT64(cfg->pin_cs) | BIT64(cfg->pin_pd);
 	gpio_cfg.mode           = GPIO_MODE_OUTPUT;
@@ -54,8 +222,12 @@ eve__open(struct devc *devc, const struct eve_cfg *cfg)
 	ESP_LOGD(TAG, "  - SPI mode:       %d", (int)cfg->spi_mode);
 	ESP_LOGD(TAG, "  - SPI speed:      %d", (int)cfg->spi_clk_speed);
 	ESP_LOGD(TAG, "  - SPI queue size: %d", (int)cfg->queue_size);
+	ESP_LOGD(TAG, "  - SPI xfer size:  %d", (int)cfg->spi_xfer_size);
+	ESP_LOGD(TAG, "  - SPI width:      %d", (int)cfg->spi_width);
+	ESP_LOGD(TAG, "  - SPI slice size: %d", (int)cfg->spi_slice_size);
 	ESP_LOGD(TAG, "  - CS pin:         %d", (int)cfg->pin_cs);
 	ESP_LOGD(TAG, "  - PD pin:         %d", (int)cfg->pin_pd);
+	ESP_LOGD(TAG, "  - INT pin:        %d", (int)cfg->pin_int);
 
 	if ((err = gpio_config(&gpio_cfg)) != ESP_OK) {
 		ESP_LOGW(TAG, "unable to setup GPIO pins: %s", esp_err_to_name(err));
@@ -64,106 +236,441 @@ eve__open(struct devc *devc, const struct eve_cfg *cfg)
 
 	devc->pin_cs = cfg->pin_cs;
 	devc->pin_pd = cfg->pin_pd;
+	devc->width = 1;
+	devc->width_max = cfg->spi_width > 1 ? cfg->spi_width : 1;
+
+#if defined(EVE_ESP32_STATS)
+	memset(&devc->stats, 0, sizeof (devc->stats));
+#endif
+
+	devc->slice_size = cfg->spi_slice_size > 0 ? cfg->spi_slice_size : 0;
+
+	/* Without DMA the bus can't transfer more than its hardware buffer. */
+	if (cfg->spi_xfer_size > 0)
+		devc->xfer_size = cfg->spi_xfer_size;
+	else
+		devc->xfer_size = SOC_SPI_MAXIMUM_BUFFER_SIZE;
 
 	gpio_set_level(devc->pin_pd, 0);
 	gpio_set_level(devc->pin_cs, 1);
 
+	devc->async_size    = cfg->queue_size > 0 ? cfg->queue_size : 1;
+	devc->async_pending = 0;
+
+	if (!(devc->async = calloc(devc->async_size, sizeof (*devc->async)))) {
+		ESP_LOGW(TAG, "unable to allocate transactions");
+		return -1;
+	}
+
 	if ((err = spi_bus_add_device(cfg->spi_host, &devc_cfg, &devc->handle)) != ESP_OK) {
 		ESP_LOGW(TAG, "unable to add device: %s", esp_err_to_name(err));
+		free(devc->async);
+		devc->async = NULL;
+		return -1;
+	}
+
+	if (!(devc->lock = xSemaphoreCreateRecursiveMutex())) {
+		ESP_LOGW(TAG, "unable to create device lock");
+		spi_bus_remove_device(devc->handle);
+		free(devc->async);
+		devc->handle = NULL;
+		devc->async = NULL;
 		return -1;
 	}
 
 	return 0;
 }
 
-static int
-eve__read(struct devc *devc, uint32_t address, void *value, int n)
+/*
+ * A burst keeps CS low for the whole operation so the data phase can be
+ * split into as many SPI transactions as the bus requires while the BT81x
+ * still sees a single burst with only one address phase.
+ */
+
+static esp_err_t
+eve__read_burst(struct devc *devc, uint32_t address, uint8_t *data, size_t n)
 {
 	esp_err_t err;
 	spi_transaction_t tx = {}, rx = {};
+	size_t len;
 
 	/* address write transaction. */
 	tx.length     = 32;
-	tx.flags      = SPI_TRANS_USE_TXDATA;
+	tx.flags      = SPI_TRANS_USE_TXDATA | WIDTH(devc);
 	tx.tx_data[0] = (address >> 16) & 0xff;
 	tx.tx_data[1] = (address >>  8) & 0xff;
 	tx.tx_data[2] = (address >>  0) & 0xff;
 
-	/* read transaction result. */
-	rx.length     = n * 8;
-	rx.rx_buffer  = value;
-
 	ACQUIRE(devc);
 
-	if ((err = spi_device_polling_transmit(devc->handle, &tx)) == ESP_OK)
-		err = spi_device_polling_transmit(devc->handle, &rx);
-	if (err != ESP_OK)
-		ESP_LOGW(TAG, "host memory read transaction error: %s", esp_err_to_name(err));
+	err = spi_device_polling_transmit(devc->handle, &tx);
+	STAT_ADD(devc, transactions, 1);
+
+	/* read transaction result. */
+	while (err == ESP_OK && n) {
+		len = n < devc->xfer_size ? n : devc->xfer_size;
+
+		/* In half duplex length is the MOSI phase which we skip. */
+		rx.flags      = WIDTH(devc);
+		rx.length     = devc->width_max > 1 ? 0 : len * 8;
+		rx.rxlength   = len * 8;
+		rx.rx_buffer  = data;
+
+		err   = spi_device_polling_transmit(devc->handle, &rx);
+		data += len;
+		n    -= len;
+		STAT_ADD(devc, transactions, 1);
+		STAT_ADD(devc, bytes_read, len);
+	}
 
 	RELEASE(devc);
 
-	return err == ESP_OK ? 0 : -1;
+	return err;
 }
 
-static int
-eve__write(struct devc *devc, uint32_t address, const void *value, int n)
+static esp_err_t
+eve__write_burst(struct devc *devc, uint32_t address, const uint8_t *data, size_t n)
 {
 	esp_err_t err;
 	spi_transaction_t txaddr = {}, txdata = {};
+	size_t len;
 
 	/* address write transaction. */
 	txaddr.length     = 24;
-	txaddr.flags      = SPI_TRANS_USE_TXDATA;
+	txaddr.flags      = SPI_TRANS_USE_TXDATA | WIDTH(devc);
 	txaddr.tx_data[0] = ((address >> 16) & 0xff) | 0x80;
 	txaddr.tx_data[1] = ((address >>  8) & 0xff);
 	txaddr.tx_data[2] = ((address >>  0) & 0xff);
 
+	ACQUIRE(devc);
+
+	err = spi_device_polling_transmit(devc->handle, &txaddr);
+	STAT_ADD(devc, transactions, 1);
+
 	/* write transaction data. */
-	txdata.length     = n * 8;
-	txdata.tx_buffer  = value;
+	while (err == ESP_OK && n) {
+		len = n < devc->xfer_size ? n : devc->xfer_size;
+
+		txdata.flags      = WIDTH(devc);
+		txdata.length     = len * 8;
+		txdata.tx_buffer  = data;
+
+		err   = spi_device_polling_transmit(devc->handle, &txdata);
+		data += len;
+		n    -= len;
+		STAT_ADD(devc, transactions, 1);
+		STAT_ADD(devc, bytes_written, len);
+	}
 
-	ACQUIRE(devc);
+	RELEASE(devc);
+
+	return err;
+}
+
+/*
+ * Long operations are cut in bursts of at most slice_size bytes and the bus
+ * is released in between. The IDF bus lock hands the bus over to any other
+ * device waiting for it, so uploads to several panels sharing the bus are
+ * interleaved slice by slice instead of one waiting for the whole frame of
+ * the other.
+ */
+
+static size_t
+eve__slice(const struct devc *devc, size_t n)
+{
+	return devc->slice_size && n > devc->slice_size ? devc->slice_size : n;
+}
+
+static int
+eve__read(struct eve *eve, uint32_t address, void *value, size_t n)
+{
+	struct devc *devc = DEVC(eve);
+	esp_err_t err = ESP_OK;
+	uint8_t *data = value;
+	size_t len;
+	int64_t start = STAT_NOW();
+
+	LOCK(devc);
+
+	while (err == ESP_OK && n) {
+		len = eve__slice(devc, n);
+		err = eve__read_burst(devc, address, data, len);
+
+		address += len;
+		data    += len;
+		n       -= len;
+	}
+
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "host memory read transaction error: %s", esp_err_to_name(err));
+		STAT_ADD(devc, errors, 1);
+	}
+
+	STAT_OP(devc, EVE_ESP32_OP_READ, start);
+	UNLOCK(devc);
+
+	return err == ESP_OK ? 0 : -1;
+}
+
+static int
+eve__write(struct eve *eve, uint32_t address, const void *value, size_t n)
+{
+	struct devc *devc = DEVC(eve);
+	esp_err_t err = ESP_OK;
+	const uint8_t *data = value;
+	size_t len;
+	int64_t start = STAT_NOW();
+
+	LOCK(devc);
+
+	while (err == ESP_OK && n) {
+		len = eve__slice(devc, n);
+		err = eve__write_burst(devc, address, data, len);
 
-	if ((err = spi_device_polling_transmit(devc->handle, &txaddr)) == ESP_OK)
-		err = spi_device_polling_transmit(devc->handle, &txdata);
-	if (err != ESP_OK)
+		/* The coprocessor FIFO is a single address. */
+		if (address != EVE_REG_CMDB_WRITE)
+			address += len;
+
+		data += len;
+		n    -= len;
+	}
+
+	if (err != ESP_OK) {
 		ESP_LOGW(TAG, "host memory write transaction error: %s", esp_err_to_name(err));
+		STAT_ADD(devc, errors, 1);
+	}
 
-	RELEASE(devc);
+	STAT_OP(devc, EVE_ESP32_OP_WRITE, start);
+	UNLOCK(devc);
 
 	return err == ESP_OK ? 0 : -1;
 }
 
-intptr_t
-eve_init(const struct eve_cfg *cfg)
+/*
+ * The INT pin is active low and stays asserted until REG_INT_FLAGS is read,
+ * the ISR can't do SPI so it just wakes up a task that reads the flags once
+ * and publishes them in the event group where eve_irq_wait picks them up.
+ */
+
+static void IRAM_ATTR
+eve__irq_isr(void *data)
 {
-	assert(cfg);
+	struct devc *devc = data;
+	BaseType_t woken = pdFALSE;
 
-	struct devc *devc = NULL;
+	vTaskNotifyGiveFromISR(devc->irq_task, &woken);
+	portYIELD_FROM_ISR(woken);
+}
 
-	for (int i = 0; i < EVE_ESP32_DEV_MAX; ++i) {
-		if (devices[i].handle == NULL) {
-			devc = &devices[i];
-			break;
-		}
+static void
+eve__irq_task(void *data)
+{
+	struct devc *devc = data;
+	uint8_t flags;
+
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		if (eve__read(EVE(devc), EVE_REG_INT_FLAGS, &flags, 1) == 0 && flags)
+			xEventGroupSetBits(devc->irq_events, flags);
 	}
+}
 
-	if (!devc) {
-		ESP_LOGW(TAG, "no more devices available");
+static void
+eve__irq_open(struct devc *devc, const struct eve_cfg *cfg)
+{
+	esp_err_t err;
+	gpio_config_t gpio_cfg = {};
+
+	devc->pin_int = GPIO_NUM_NC;
+
+	if (cfg->pin_int == GPIO_NUM_NC)
+		return;
+
+	gpio_cfg.pin_bit_mask   = BIT64(cfg->pin_int);
+	gpio_cfg.mode           = GPIO_MODE_INPUT;
+	gpio_cfg.pull_up_en     = GPIO_PULLUP_ENABLE;
+	gpio_cfg.intr_type      = GPIO_INTR_NEGEDGE;
+
+	if ((err = gpio_config(&gpio_cfg)) != ESP_OK) {
+		ESP_LOGW(TAG, "unable to setup INT pin: %s", esp_err_to_name(err));
+		return;
+	}
+
+	/* May already be installed by someone else. */
+	if ((err = gpio_install_isr_service(0)) != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+		ESP_LOGW(TAG, "unable to install ISR service: %s", esp_err_to_name(err));
+		return;
+	}
+
+	if (!(devc->irq_events = xEventGroupCreate()))
+		goto fail;
+	if (xTaskCreate(eve__irq_task, "eve-irq", 2048, devc, EVE_ESP32_IRQ_PRIO, &devc->irq_task) != pdPASS)
+		goto fail;
+	if (gpio_isr_handler_add(cfg->pin_int, eve__irq_isr, devc) != ESP_OK)
+		goto fail;
+
+	devc->pin_int = cfg->pin_int;
+
+	return;
+
+fail:
+	ESP_LOGW(TAG, "unable to setup interrupts, falling back to polling");
+
+	if (devc->irq_task)
+		vTaskDelete(devc->irq_task);
+	if (devc->irq_events)
+		vEventGroupDelete(devc->irq_events);
+
+	devc->irq_task = NULL;
+	devc->irq_events = NULL;
+}
+
+static void
+eve__irq_close(struct devc *devc)
+{
+	if (devc->pin_int == GPIO_NUM_NC)
+		return;
+
+	gpio_isr_handler_remove(devc->pin_int);
+
+	/* Don't kill the task in the middle of a read, holding the lock. */
+	LOCK(devc);
+	vTaskDelete(devc->irq_task);
+	UNLOCK(devc);
+
+	vEventGroupDelete(devc->irq_events);
+
+	devc->pin_int = GPIO_NUM_NC;
+	devc->irq_task = NULL;
+	devc->irq_events = NULL;
+}
+
+static int
+eve__power(struct eve *eve, int enable)
+{
+	struct devc *devc = DEVC(eve);
+
+	LOCK(devc);
+	gpio_set_level(devc->pin_pd, enable);
+
+	if (!enable)
+		devc->width = 1;
+
+	UNLOCK(devc);
+
+	return 0;
+}
+
+static int
+eve__irq_enable(struct eve *eve, uint8_t mask)
+{
+	struct devc *self = DEVC(eve);
+	uint8_t flags;
+	int rc = -1;
+
+	if (self->pin_int == GPIO_NUM_NC)
 		return -1;
+
+	LOCK(self);
+
+	/* Drop anything that happened before. */
+	if (eve__write(eve, EVE_REG_INT_MASK, &mask, 1) == 0 &&
+	    eve__read(eve, EVE_REG_INT_FLAGS, &flags, 1) == 0) {
+		xEventGroupClearBits(self->irq_events, 0xff);
+		flags = mask ? 1 : 0;
+		rc = eve__write(eve, EVE_REG_INT_EN, &flags, 1);
 	}
-	if (eve__open(devc, cfg) < 0)
+
+	UNLOCK(self);
+
+	return rc;
+}
+
+static int
+eve__irq_wait(struct eve *eve, uint8_t mask, uint32_t timeout_ms)
+{
+	struct devc *self = DEVC(eve);
+	TickType_t ticks;
+
+	if (self->pin_int == GPIO_NUM_NC)
 		return -1;
 
-	return (intptr_t)devc;
+	ticks = timeout_ms == EVE_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+	return xEventGroupWaitBits(self->irq_events, mask, pdTRUE, pdFALSE, ticks) & mask;
 }
 
-int
-eve_power(intptr_t devc, int enable)
+static int
+eve__check_width(struct eve *eve, uint8_t expected)
 {
-	gpio_set_level(DEVC(devc)->pin_pd, enable);
+	uint8_t width = 0xff, id = 0;
 
-	return 0;
+	if (eve__read(eve, EVE_REG_SPI_WIDTH, &width, 1) < 0 ||
+	    eve__read(eve, EVE_REG_ID, &id, 1) < 0)
+		return -1;
+
+	return (width & 0x3) == expected && id == EVE_ID ? 0 : -1;
+}
+
+static int
+eve__switch_width(struct eve *eve, int width)
+{
+	struct devc *self = DEVC(eve);
+	uint8_t value;
+
+	switch (width) {
+	case 1:
+		value = 0;
+		break;
+	case 2:
+		value = 1;
+		break;
+	case 4:
+		value = 2;
+		break;
+	default:
+		return -1;
+	}
+
+	if (width > self->width_max) {
+		ESP_LOGW(TAG, "%d-line SPI not configured", width);
+		return -1;
+	}
+
+	if (eve__write(eve, EVE_REG_SPI_WIDTH, &value, 1) < 0)
+		return -1;
+
+	self->width = width;
+
+	if (eve__check_width(eve, value) == 0) {
+		ESP_LOGI(TAG, "SPI link using %d line(s)", width);
+		return 0;
+	}
+
+	ESP_LOGW(TAG, "%d-line SPI verification failed, falling back to single line", width);
+
+	/* Revert the device side using the new width then ours. */
+	value = 0;
+	eve__write(eve, EVE_REG_SPI_WIDTH, &value, 1);
+	self->width = 1;
+
+	if (eve__check_width(eve, 0) < 0)
+		ESP_LOGE(TAG, "device unreachable, power cycle required");
+
+	return -1;
+}
+
+static int
+eve__set_width(struct eve *eve, int width)
+{
+	int rc;
+
+	LOCK(DEVC(eve));
+	rc = eve__switch_width(eve, width);
+	UNLOCK(DEVC(eve));
+
+	return rc;
 }
 
 /*
@@ -171,81 +678,289 @@ eve_power(intptr_t devc, int enable)
  * smart enough to choose correct one.
  */
 
-int
-eve_cmd(intptr_t devc, uint8_t cmd, uint8_t param)
+static int
+eve__cmd(struct eve *eve, uint8_t cmd, uint8_t param)
 {
+	struct devc *devc = DEVC(eve);
 	esp_err_t err;
 	spi_transaction_t tx = {};
+	int64_t start = STAT_NOW();
 
 	tx.length     = 24;
 	tx.tx_data[0] = cmd;
 	tx.tx_data[1] = param;
-	tx.flags      = SPI_TRANS_USE_TXDATA;
+	tx.flags      = SPI_TRANS_USE_TXDATA | WIDTH(devc);
 
-	gpio_set_level(DEVC(devc)->pin_cs, 0);
+	LOCK(devc);
+	ACQUIRE(devc);
 
-	if ((err = spi_device_polling_transmit(DEVC(devc)->handle, &tx)) != ESP_OK)
+	if ((err = spi_device_polling_transmit(devc->handle, &tx)) != ESP_OK) {
 		ESP_LOGW(TAG, "command failed: %s", esp_err_to_name(err));
+		STAT_ADD(devc, errors, 1);
+	}
+
+	RELEASE(devc);
+	STAT_ADD(devc, transactions, 1);
+	STAT_OP(devc, EVE_ESP32_OP_CMD, start);
 
-	gpio_set_level(DEVC(devc)->pin_cs, 1);
+	/* Core reset puts REG_SPI_WIDTH back to a single line. */
+	if (cmd == EVE_CMD_RST_PULSE)
+		devc->width = 1;
+
+	UNLOCK(devc);
 
 	return err == ESP_OK ? 0 : -1;
 }
 
-int
-eve_read8(intptr_t devc, uint32_t address, uint8_t *value)
+static int
+eve__write_async(struct eve *eve,
+                 uint32_t address,
+                 const void *data,
+                 size_t size,
+                 eve_async_cb_t cb,
+                 void *arg)
 {
-	return eve__read(DEVC(devc), address, value, 1);
+	struct devc *self = DEVC(eve);
+	struct async *async, *last = NULL;
+	const uint8_t *buf = data;
+	size_t len;
+	esp_err_t err;
+
+	LOCK(self);
+
+	while (size) {
+		len = size < self->xfer_size ? size : self->xfer_size;
+		async = eve__async_get(self);
+
+		memset(&async->tx, 0, sizeof (async->tx));
+		async->tx.base.flags     = SPI_TRANS_VARIABLE_ADDR | WIDTH(self);
+		async->tx.base.addr      = (address & 0x3fffff) | 0x800000;
+		async->tx.base.length    = len * 8;
+		async->tx.base.tx_buffer = buf;
+		async->tx.base.user      = async;
+		async->tx.address_bits   = 24;
+		async->devc              = self;
+
+		/* Only the last chunk reports completion. */
+		async->cb     = len == size ? cb : NULL;
+		async->arg    = arg;
+		async->status = 0;
+		async->start  = STAT_NOW();
+
+		if ((err = spi_device_queue_trans(self->handle, &async->tx.base, portMAX_DELAY)) != ESP_OK) {
+			ESP_LOGW(TAG, "unable to queue transaction: %s", esp_err_to_name(err));
+			STAT_ADD(self, errors, 1);
+
+			/*
+			 * The rest is never sent. The callback still runs once, from
+			 * the last chunk in flight so the data is released after it.
+			 */
+			if (last && last->busy) {
+				last->cb = cb;
+				last->arg = arg;
+				last->status = -1;
+			} else if (cb)
+				cb(arg, -1);
+
+			UNLOCK(self);
+			return -1;
+		}
+
+		STAT_ADD(self, transactions, 1);
+		STAT_ADD(self, bytes_written, len);
+
+		async->busy = 1;
+		self->async_pending++;
+		last = async;
+
+		/* The coprocessor FIFO is a single address. */
+		if (address != EVE_REG_CMDB_WRITE)
+			address += len;
+
+		buf  += len;
+		size -= len;
+	}
+
+	UNLOCK(self);
+
+	return 0;
 }
 
-int
-eve_read16(intptr_t devc, uint32_t address, uint16_t *value)
+static int
+eve__async_poll(struct eve *eve)
 {
-	return eve__read(DEVC(devc), address, value, 2);
+	struct devc *self = DEVC(eve);
+	int pending;
+
+	LOCK(self);
+
+	while (self->async_pending && eve__async_reap(self, 0) == 0)
+		continue;
+
+	pending = self->async_pending;
+	UNLOCK(self);
+
+	return pending;
 }
 
-int
-eve_read32(intptr_t devc, uint32_t address, uint32_t *value)
+static int
+eve__async_wait(struct eve *eve)
 {
-	assert(value);
+	LOCK(DEVC(eve));
+	eve__async_drain(DEVC(eve));
+	UNLOCK(DEVC(eve));
 
-	return eve__read(DEVC(devc), address, value, 4);
+	return 0;
 }
 
-int
-eve_write8(intptr_t devc, uint32_t address, uint8_t value)
+static void
+eve__lock(struct eve *eve)
 {
-	return eve__write(DEVC(devc), address, &value, 1);
+	LOCK(DEVC(eve));
 }
 
-int
-eve_write16(intptr_t devc, uint32_t address, uint16_t value)
+static void
+eve__unlock(struct eve *eve)
 {
-	return eve__write(DEVC(devc), address, &value, 2);
+	UNLOCK(DEVC(eve));
 }
 
-int
-eve_write32(intptr_t devc, uint32_t address, uint32_t value)
+static int64_t
+eve__time(struct eve *eve)
 {
-	return eve__write(DEVC(devc), address, &value, 4);
+	(void)eve;
+
+	return esp_timer_get_time();
 }
 
-void
-eve_finish(intptr_t devc)
+/*
+ * Delays shorter than a tick are spun, longer ones let lower priority tasks
+ * run.
+ */
+static void
+eve__sleep(struct eve *eve, uint32_t us)
 {
-	struct devc *self = DEVC(devc);
+	(void)eve;
+
+	TickType_t ticks;
 
-	if (!devc)
+	/* Only the first short polls spin, backed off ones yield the CPU. */
+	if (us <= EVE_ESP32_SPIN_MAX_US) {
+		esp_rom_delay_us(us);
 		return;
+	}
+
+	ticks = (us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+	vTaskDelay(ticks);
+}
+
+static void
+eve__finish(struct eve *eve)
+{
+	struct devc *self = DEVC(eve);
+
+	LOCK(self);
+	eve__irq_close(self);
+	eve__async_drain(self);
 
 	gpio_set_level(self->pin_pd, 0);
 	gpio_set_level(self->pin_cs, 1);
 
 	spi_bus_remove_device(self->handle);
+	free(self->async);
+
+	self->eve.ops = NULL;
+	self->handle  = NULL;
+	self->async   = NULL;
+	self->pin_cs  = 0;
+	self->pin_pd  = 0;
 
-	self->handle = NULL;
-	self->pin_cs = 0;
-	self->pin_pd = 0;
+	UNLOCK(self);
+	vSemaphoreDelete(self->lock);
+	self->lock = NULL;
+
+	taskENTER_CRITICAL(&devices_lock);
+	self->used = 0;
+	taskEXIT_CRITICAL(&devices_lock);
 }
 
+static const struct eve_ops ops = {
+	.read        = eve__read,
+	.write       = eve__write,
+	.write_async = eve__write_async,
+	.async_poll  = eve__async_poll,
+	.async_wait  = eve__async_wait,
+	.cmd         = eve__cmd,
+	.power       = eve__power,
+	.set_width   = eve__set_width,
+	.irq_enable  = eve__irq_enable,
+	.irq_wait    = eve__irq_wait,
+	.lock        = eve__lock,
+	.unlock      = eve__unlock,
+	.time        = eve__time,
+	.sleep       = eve__sleep,
+	.finish      = eve__finish,
+};
+
+intptr_t
+eve_init(const struct eve_cfg *cfg)
+{
+	assert(cfg);
+
+	struct devc *devc = NULL;
+
+	/* Several tasks may bring up their own panel at the same time. */
+	taskENTER_CRITICAL(&devices_lock);
+
+	for (int i = 0; i < EVE_ESP32_DEV_MAX; ++i) {
+		if (!devices[i].used) {
+			devc = &devices[i];
+			devc->used = 1;
+			break;
+		}
+	}
+
+	taskEXIT_CRITICAL(&devices_lock);
+
+	if (!devc) {
+		ESP_LOGW(TAG, "no more devices available");
+		return -1;
+	}
+	if (eve__open(devc, cfg) < 0) {
+		devc->used = 0;
+		return -1;
+	}
+
+	eve__irq_open(devc, cfg);
+	memset(&devc->eve, 0, sizeof (devc->eve));
+	devc->eve.ops = &ops;
+
+	return (intptr_t)EVE(devc);
+}
+
+#if defined(EVE_ESP32_STATS)
+
+int
+eve_esp32_stats(intptr_t devc, struct eve_esp32_stats *stats)
+{
+	assert(stats);
+
+	/* Consistent copy, transfers update them under the lock. */
+	LOCK(DEVC(devc));
+	*stats = DEVC(devc)->stats;
+	UNLOCK(DEVC(devc));
+
+	return 0;
+}
+
+void
+eve_esp32_stats_reset(intptr_t devc)
+{
+	LOCK(DEVC(devc));
+	memset(&DEVC(devc)->stats, 0, sizeof (DEVC(devc)->stats));
+	UNLOCK(DEVC(devc));
+}
+
+#endif
+
 #endif /* !EVE_ESP32 */
@@ -12,7 +12,22 @@
  * Controls how many devices the system has.
  */
 #ifndef EVE_ESP32_DEV_MAX
-#       define EVE_ESP32_DEV_MAX 1
+#       define EVE_ESP32_DEV_MAX 2
+#endif
+
+/**
+ * Priority of the task reading REG_INT_FLAGS when the INT pin fires.
+ */
+#ifndef EVE_ESP32_IRQ_PRIO
+#       define EVE_ESP32_IRQ_PRIO 10
+#endif
+
+/**
+ * Longest delay busy waited by the polling waits, longer ones block for at
+ * least a tick so that lower priority tasks and IDLE keep running.
+ */
+#ifndef EVE_ESP32_SPIN_MAX_US
+#       define EVE_ESP32_SPIN_MAX_US 250
 #endif
 
 #endif
@@ -20,10 +35,84 @@
 struct eve_cfg {
 	gpio_num_t pin_cs;
 	gpio_num_t pin_pd;
+
+	/*
+	 * Interrupt line, GPIO_NUM_NC if not wired in which case the
+	 * eve_wait_* functions poll registers instead.
+	 */
+	gpio_num_t pin_int;
 	int8_t  spi_mode;
 	int64_t spi_clk_speed;
 	spi_host_device_t spi_host;
+
+	/*
+	 * Number of asynchronous transactions that can be in flight, see
+	 * eve_write_async.
+	 */
 	int16_t queue_size;
+
+	/*
+	 * Largest SPI transaction the bus accepts, bursts are split in
+	 * transactions of this size. Defaults to the hardware buffer size
+	 * which is the limit when DMA is disabled.
+	 */
+	int32_t spi_xfer_size;
+
+	/*
+	 * Maximum number of data lines wired (1, 2 or 4). When greater than 1
+	 * the device is configured as half duplex as required by the IDF for
+	 * multi-line transactions, the link itself starts with a single line
+	 * until eve_set_width is called.
+	 */
+	int8_t spi_width;
+
+	/*
+	 * Longest burst in bytes before the bus is released for other
+	 * devices sharing it, 0 to keep it for the whole operation. Every
+	 * slice costs an extra address phase.
+	 */
+	int32_t spi_slice_size;
+};
+
+#if defined(EVE_ESP32_STATS)
+
+/**
+ * Operations timed in the latency histograms.
+ */
+enum eve_esp32_op {
+	EVE_ESP32_OP_READ,
+	EVE_ESP32_OP_WRITE,
+	EVE_ESP32_OP_CMD,
+	EVE_ESP32_OP_ASYNC,             /* from queueing to completion */
+	EVE_ESP32_OP_MAX
 };
 
+/**
+ * Number of latency buckets, bucket 0 counts operations under 1us and bucket
+ * i those in [2^(i-1), 2^i) us, the last one everything longer.
+ */
+#ifndef EVE_ESP32_HIST_MAX
+#       define EVE_ESP32_HIST_MAX 16
+#endif
+
+struct eve_esp32_stats {
+	uint32_t transactions;          /* SPI transactions issued */
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+	uint64_t acquire_us;            /* time spent waiting for the bus */
+	uint32_t errors;                /* failed SPI transactions */
+	uint32_t hist[EVE_ESP32_OP_MAX][EVE_ESP32_HIST_MAX];
+};
+
+/**
+ * Copy the bus counters since the device was opened or last reset.
+ */
+int
+eve_esp32_stats(intptr_t devc, struct eve_esp32_stats *stats);
+
+void
+eve_esp32_stats_reset(intptr_t devc);
+
+#endif
+
 #endif /* !EVE_ESP32_H */
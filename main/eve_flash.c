@@ -0,0 +1,149 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_flash.h"
+
+#define ALIGN(v, a)     (((v) + (a) - 1) & ~((a) - 1))
+
+/* Block dimensions of the ASTC formats, EVE_FORMAT_ASTC_4X4 onwards. */
+static const struct {
+	uint8_t w;
+	uint8_t h;
+} astc_blocks[] = {
+	{  4,  4 }, {  5,  4 }, {  5,  5 }, {  6,  5 }, {  6,  6 },
+	{  8,  5 }, {  8,  6 }, {  8,  8 }, { 10,  5 }, { 10,  6 },
+	{ 10,  8 }, { 10, 10 }, { 12, 10 }, { 12, 12 },
+};
+
+/*
+ * Run a flash command and wait for the flash to report the expected status.
+ */
+static int
+flash_cmd(struct eve_cp *cp, uint32_t cmd, uint8_t expect)
+{
+	uint8_t status;
+
+	if (eve_cp_push(cp, cmd) < 0 || eve_cp_wait(cp) < 0)
+		return -1;
+	if (eve_read8(cp->devc, EVE_REG_FLASH_STATUS, &status) < 0)
+		return -1;
+
+	return status == expect ? 0 : -1;
+}
+
+int
+eve_flash_attach(struct eve_cp *cp)
+{
+	assert(cp);
+
+	return flash_cmd(cp, EVE_CPC_FLASHATTACH, EVE_FLASH_STATUS_BASIC);
+}
+
+int
+eve_flash_detach(struct eve_cp *cp)
+{
+	assert(cp);
+
+	return flash_cmd(cp, EVE_CPC_FLASHDETACH, EVE_FLASH_STATUS_DETACHED);
+}
+
+int
+eve_flash_fast(struct eve_cp *cp, uint32_t *result)
+{
+	assert(cp);
+
+	uint32_t value = EVE_FLASH_ENOTATTACHED;
+	uint16_t wp;
+	uint8_t status;
+	int rc = -1;
+
+	/*
+	 * The result replaces the word following the command in RAM_CMD, its
+	 * position is known once the command reached the FIFO.
+	 */
+	if (eve_cp_push(cp, EVE_CPC_FLASHFAST) < 0 ||
+	    eve_cp_push(cp, 0) < 0 ||
+	    eve_cp_flush(cp) < 0 ||
+	    eve_read16(cp->devc, EVE_REG_CMD_WRITE, &wp) < 0 ||
+	    eve_wait_cmdempty(cp->devc, EVE_WAIT_FOREVER) < 0 ||
+	    eve_read32(cp->devc, EVE_MAP_RAM_CMD + ((wp - 4) & 0xffc), &value) < 0)
+		goto out;
+
+	if (eve_read8(cp->devc, EVE_REG_FLASH_STATUS, &status) == 0 &&
+	    status == EVE_FLASH_STATUS_FULL && value == EVE_FLASH_OK)
+		rc = 0;
+
+out:
+	if (result)
+		*result = value;
+
+	return rc;
+}
+
+int
+eve_flash_program(struct eve_cp *cp,
+                  uint32_t dest,
+                  const void *data,
+                  size_t size,
+                  uint32_t staging,
+                  uint32_t staging_size)
+{
+	assert(cp);
+	assert(data || size == 0);
+
+	const uint8_t *src = data;
+	size_t n, padded;
+
+	if (dest % EVE_FLASH_SECTOR || staging % EVE_FLASH_SECTOR ||
+	    staging_size < EVE_FLASH_SECTOR || staging_size % EVE_FLASH_SECTOR)
+		return -1;
+
+	/* Staging is reused right away, the FIFO keeps the commands in order. */
+	for (; size; src += n, size -= n, dest += padded) {
+		n = size < staging_size ? size : staging_size;
+		padded = ALIGN(n, EVE_FLASH_SECTOR);
+
+		if (eve_cp_memwrite(cp, staging, src, n) < 0)
+			return -1;
+		if (padded > n && eve_cp_memset(cp, staging + n, 0xff, padded - n) < 0)
+			return -1;
+
+		if (eve_cp_push(cp, EVE_CPC_FLASHUPDATE) < 0 ||
+		    eve_cp_push(cp, dest) < 0 ||
+		    eve_cp_push(cp, staging) < 0 ||
+		    eve_cp_push(cp, padded) < 0)
+			return -1;
+	}
+
+	return eve_cp_wait(cp);
+}
+
+int
+eve_flash_astc(struct eve_dl *dl,
+               uint8_t handle,
+               uint32_t address,
+               uint32_t format,
+               uint16_t width,
+               uint16_t height)
+{
+	assert(dl);
+
+	uint32_t index = format - EVE_FORMAT_ASTC_4X4;
+	uint16_t stride, rows;
+
+	if (index >= sizeof (astc_blocks) / sizeof (astc_blocks[0]) || address % EVE_FLASH_ALIGN)
+		return -1;
+
+	/* One 16 bytes block per bw x bh pixels. */
+	stride = (width + astc_blocks[index].w - 1) / astc_blocks[index].w * 16;
+	rows = (height + astc_blocks[index].h - 1) / astc_blocks[index].h;
+
+	eve_dl_bitmap_handle(dl, handle);
+	eve_dl_bitmap_source(dl, EVE_FLASH_SOURCE(address));
+	eve_dl_bitmap_layout(dl, EVE_FORMAT_GLFORMAT, stride, rows);
+	eve_dl_bitmap_ext_format(dl, format);
+	eve_dl_bitmap_size(dl, 0, 0, 0, width, height);
+
+	return dl->overflow ? -1 : 0;
+}
@@ -0,0 +1,99 @@
+#ifndef EVE_FLASH_H
+#define EVE_FLASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * External serial flash behind the BT816.
+ *
+ * The coprocessor attaches the flash and switches it to fast (QSPI) mode,
+ * which requires the BRT blob in its first sector. Images built by
+ * tools/eveflash.py hold the blob and the assets, with a generated header
+ * giving the offset of each of them.
+ *
+ * Data is programmed with CMD_FLASHUPDATE from a staging area in RAM_G. Only
+ * sectors that differ are erased and written, so programming the same image
+ * again doesn't wear the flash.
+ *
+ * In fast mode ASTC bitmaps are drawn straight from flash: nothing is copied
+ * into RAM_G nor sent over SPI at draw time.
+ */
+
+struct eve_cp;
+struct eve_dl;
+
+/* Erase unit, CMD_FLASHUPDATE works on whole sectors. */
+#define EVE_FLASH_SECTOR                4096U
+
+/* Sector 0 is reserved for the blob. */
+#define EVE_FLASH_BLOB_SIZE             4096U
+
+/* Alignment of ASTC data in flash. */
+#define EVE_FLASH_ALIGN                 64U
+
+/* BITMAP_SOURCE value for data at the given flash address. */
+#define EVE_FLASH_SOURCE(address)       (EVE_MAP_FLASH | ((address) / 32))
+
+/* CMD_FLASHFAST results. */
+#define EVE_FLASH_OK                    0x0000U
+#define EVE_FLASH_ENOTATTACHED          0xe001U
+#define EVE_FLASH_ENOBLOB               0xe002U
+#define EVE_FLASH_EBLOB                 0xe003U
+#define EVE_FLASH_EMISMATCH             0xe004U
+#define EVE_FLASH_ESPEED                0xe005U
+
+/**
+ * Attach the flash in basic (single line) mode.
+ *
+ * Returns -1 if no flash answered.
+ */
+int
+eve_flash_attach(struct eve_cp *cp);
+
+/**
+ * Detach the flash, its pins are released.
+ */
+int
+eve_flash_detach(struct eve_cp *cp);
+
+/**
+ * Switch an attached flash to fast mode.
+ *
+ * The CMD_FLASHFAST result (EVE_FLASH_*) is stored in result unless NULL,
+ * returns -1 unless the flash ends up in EVE_FLASH_STATUS_FULL.
+ */
+int
+eve_flash_fast(struct eve_cp *cp, uint32_t *result);
+
+/**
+ * Program size bytes of data at dest, a multiple of EVE_FLASH_SECTOR.
+ *
+ * Data goes through staging_size bytes of RAM_G at staging, both multiples
+ * of EVE_FLASH_SECTOR, the last sector is padded with 0xff. Returns once the
+ * coprocessor is done.
+ */
+int
+eve_flash_program(struct eve_cp *cp,
+                  uint32_t dest,
+                  const void *data,
+                  size_t size,
+                  uint32_t staging,
+                  uint32_t staging_size);
+
+/**
+ * Bind bitmap handle to an ASTC image stored in flash at address.
+ *
+ * Emits BITMAP_HANDLE, BITMAP_SOURCE, BITMAP_LAYOUT, BITMAP_EXT_FORMAT and
+ * BITMAP_SIZE. Returns -1 if the format is not ASTC or the address not
+ * EVE_FLASH_ALIGN aligned.
+ */
+int
+eve_flash_astc(struct eve_dl *dl,
+               uint8_t handle,
+               uint32_t address,
+               uint32_t format,
+               uint16_t width,
+               uint16_t height);
+
+#endif /* !EVE_FLASH_H */
@@ -0,0 +1,194 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_font.h"
+
+/* Metric block fields after the widths. */
+#define METRICS_HEIGHT  140
+#define METRICS_POINTER 144
+
+/* Largest VERTEX2II coordinate. */
+#define VERTEX2II_MAX   511
+
+static void
+font_metrics(struct eve_font *font, const uint8_t *block)
+{
+	uint32_t height;
+
+	memcpy(font->widths, block, sizeof (font->widths));
+	memcpy(&height, &block[METRICS_HEIGHT], 4);
+	font->height = height;
+}
+
+static int
+font_has(const struct eve_font *font, uint8_t c)
+{
+	return c >= font->first && c < 128 && c != ' ' && font->widths[c];
+}
+
+int
+eve_font_rom(struct eve_font *font, intptr_t devc, uint8_t id)
+{
+	assert(font);
+
+	uint8_t block[EVE_FONT_METRICS_SIZE];
+	uint32_t root;
+
+	if (id < 16 || id > 31)
+		return -1;
+
+	if (eve_read32(devc, EVE_ROM_FONTROOT, &root) < 0 ||
+	    eve_read(devc, root + (id - 16) * EVE_FONT_METRICS_SIZE, block, sizeof (block)) < 0)
+		return -1;
+
+	font_metrics(font, block);
+	font->handle = id;
+	font->first = 32;
+
+	return 0;
+}
+
+int
+eve_font_load(struct eve_font *font,
+              struct eve_cp *cp,
+              uint8_t handle,
+              uint32_t ptr,
+              const void *data,
+              size_t size,
+              uint8_t first)
+{
+	assert(font);
+	assert(cp);
+	assert(data);
+
+	uint8_t block[EVE_FONT_METRICS_SIZE];
+	uint32_t pointer = ptr + EVE_FONT_METRICS_SIZE;
+
+	if (handle > 31 || ptr % 4 || size < EVE_FONT_METRICS_SIZE)
+		return -1;
+
+	memcpy(block, data, sizeof (block));
+	memcpy(&block[METRICS_POINTER], &pointer, 4);
+
+	if (eve_cp_memwrite(cp, ptr, block, sizeof (block)) < 0 ||
+	    eve_cp_memwrite(cp, pointer, (const uint8_t *)data + sizeof (block), size - sizeof (block)) < 0)
+		return -1;
+
+	if (eve_cp_push(cp, EVE_CPC_SETFONT2) < 0 ||
+	    eve_cp_push(cp, handle) < 0 ||
+	    eve_cp_push(cp, ptr) < 0 ||
+	    eve_cp_push(cp, first) < 0 ||
+	    eve_cp_wait(cp) < 0)
+		return -1;
+
+	font_metrics(font, block);
+	font->handle = handle;
+	font->first = first;
+
+	return 0;
+}
+
+uint32_t
+eve_font_width(const struct eve_font *font, const char *str, size_t n)
+{
+	assert(font);
+	assert(str);
+
+	uint32_t width = 0;
+	uint8_t c;
+
+	for (size_t i = 0; i < n && str[i]; ++i) {
+		c = str[i];
+		width += c < 128 ? font->widths[c] : 0;
+	}
+
+	return width;
+}
+
+size_t
+eve_font_fit(const struct eve_font *font, const char *str, uint32_t width, size_t *next)
+{
+	assert(font);
+	assert(str);
+
+	uint32_t used = 0;
+	size_t i, cut = 0;
+	uint8_t c;
+
+	for (i = 0; str[i] && str[i] != '\n'; ++i) {
+		c = str[i];
+
+		if (c == ' ')
+			cut = i;
+
+		used += c < 128 ? font->widths[c] : 0;
+
+		if (used > width)
+			break;
+	}
+
+	/* Whole string or a single word too long for the line. */
+	if (!str[i] || str[i] == '\n' || !cut)
+		cut = i;
+
+	/* Always make progress, even if the first glyph is too wide. */
+	if (!cut && str[0] && str[0] != '\n')
+		cut = 1;
+
+	if (next) {
+		for (*next = cut; str[*next] == ' '; ++*next)
+			;
+		if (str[*next] == '\n' && *next == i)
+			++*next;
+	}
+
+	return cut;
+}
+
+void
+eve_font_begin(struct eve_dl *dl)
+{
+	eve_dl_begin(dl, EVE_PRIM_BITMAPS);
+}
+
+void
+eve_font_run(struct eve_dl *dl, const struct eve_font *font, int16_t x, int16_t y, const char *str, size_t n)
+{
+	assert(dl);
+	assert(font);
+	assert(str);
+
+	uint32_t dx = 0;
+	uint8_t c;
+
+	eve_dl_push(dl, EVE__DL_VERTEX_TRANSLATE_X(x * 16));
+	eve_dl_push(dl, EVE__DL_VERTEX_TRANSLATE_Y(y * 16));
+
+	for (size_t i = 0; i < n && str[i]; ++i) {
+		c = str[i];
+
+		if (!font_has(font, c)) {
+			dx += c < 128 ? font->widths[c] : 0;
+			continue;
+		}
+
+		/* Out of VERTEX2II reach, the origin moves along. */
+		if (dx > VERTEX2II_MAX) {
+			x += dx;
+			dx = 0;
+			eve_dl_push(dl, EVE__DL_VERTEX_TRANSLATE_X(x * 16));
+		}
+
+		eve_dl_push(dl, EVE__DL_VERTEX2II(dx, 0, font->handle, c));
+		dx += font->widths[c];
+	}
+}
+
+void
+eve_font_end(struct eve_dl *dl)
+{
+	eve_dl_push(dl, EVE__DL_VERTEX_TRANSLATE_X(0));
+	eve_dl_push(dl, EVE__DL_VERTEX_TRANSLATE_Y(0));
+	eve_dl_end(dl);
+}
@@ -0,0 +1,100 @@
+#ifndef EVE_FONT_H
+#define EVE_FONT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Fonts and glyph run text.
+ *
+ * Glyph widths are cached on the host when a font is loaded so text is
+ * measured and wrapped without reading the device. Text is then drawn as
+ * glyph runs: a VERTEX_TRANSLATE to the run origin followed by one VERTEX2II
+ * per visible glyph, all under one BEGIN(BITMAPS) for as many runs as
+ * wanted.
+ *
+ * Runs go in host built lists, the frame path doesn't involve the
+ * coprocessor. A CMD_TEXT sends fewer bytes (12 plus the string) but the
+ * coprocessor then writes the same VERTEX2II per glyph to RAM_DL, with its
+ * own state setup around each label.
+ *
+ * Fonts use the legacy metric block, ROM fonts 16 to 31 or custom fonts in
+ * RAM_G installed with CMD_SETFONT2. Glyphs are bitmap cells, so characters
+ * are limited to 1 to 127. Extended format fonts address each glyph
+ * through its own bitmap pointer, which VERTEX2II can't do, they keep to
+ * CMD_TEXT.
+ */
+
+struct eve_cp;
+struct eve_dl;
+
+/* Size of a legacy metric block. */
+#define EVE_FONT_METRICS_SIZE           148
+
+struct eve_font {
+	uint8_t handle;
+	uint8_t first;                  /* first character in the font */
+	uint8_t height;                 /* line height, pixels */
+	uint8_t widths[128];            /* advance, pixels */
+};
+
+/**
+ * Cache the metrics of ROM font 16 to 31, also its bitmap handle.
+ */
+int
+eve_font_rom(struct eve_font *font, intptr_t devc, uint8_t id);
+
+/**
+ * Upload a font converted to the legacy format into RAM_G at ptr and
+ * install it on handle with CMD_SETFONT2.
+ *
+ * data is the metric block followed by the glyph bitmaps, the bitmap
+ * pointer of the block is set to follow it. first is the first character
+ * of the font, glyphs before it are not stored.
+ */
+int
+eve_font_load(struct eve_font *font,
+              struct eve_cp *cp,
+              uint8_t handle,
+              uint32_t ptr,
+              const void *data,
+              size_t size,
+              uint8_t first);
+
+/**
+ * Width in pixels of the n first characters of str.
+ */
+uint32_t
+eve_font_width(const struct eve_font *font, const char *str, size_t n);
+
+/**
+ * Number of characters of str fitting in width pixels, cut after the last
+ * space that fits if any. Spaces following the cut are not counted, the
+ * next line starts at str + *next unless next is NULL.
+ *
+ * At least one character is taken unless str is empty or starts with a line
+ * break, a glyph wider than width gets a line of its own.
+ */
+size_t
+eve_font_fit(const struct eve_font *font, const char *str, uint32_t width, size_t *next);
+
+/**
+ * Start glyph runs, BEGIN(BITMAPS).
+ */
+void
+eve_font_begin(struct eve_dl *dl);
+
+/**
+ * Draw the n first characters of str at x, y. Spaces and characters the
+ * font doesn't have only advance.
+ */
+void
+eve_font_run(struct eve_dl *dl, const struct eve_font *font, int16_t x, int16_t y, const char *str, size_t n);
+
+/**
+ * End glyph runs, VERTEX_TRANSLATE is back to 0.
+ */
+void
+eve_font_end(struct eve_dl *dl);
+
+#endif /* !EVE_FONT_H */
@@ -0,0 +1,205 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_frame.h"
+
+/*
+ * Pending swap done? The SWAP interrupt is used when available, the register
+ * is polled otherwise. An interrupt may be left over from a swap that wasn't
+ * ours (coprocessor CMD_SWAP, eve_dl_swap) so it is confirmed by reading
+ * REG_DLSWAP back.
+ */
+static int
+swap_done(struct eve_frame *frame)
+{
+	uint8_t value;
+	int rc;
+
+	/* Consumed by eve_frame_wait, or a swap pending across eve_frame_resume. */
+	if (frame->swap_irq)
+		frame->swap_irq = 0;
+	else if ((rc = eve_irq_wait(frame->devc, EVE_IRQ_SWAP, 0)) >= 0) {
+		frame->irq = 1;
+
+		if (rc == 0)
+			return 0;
+	}
+
+	if (eve_read8(frame->devc, EVE_REG_DLSWAP, &value) < 0)
+		return 0;
+
+	return value == EVE_DLSWAP_DONE;
+}
+
+static void
+swap_complete(struct eve_frame *frame, int64_t now_us)
+{
+	struct eve_frame_stats *st = &frame->stats;
+	uint32_t frames;
+	int64_t jitter;
+
+	frame->pending = 0;
+
+	if (eve_read32(frame->devc, EVE_REG_FRAMES, &frames) < 0)
+		frames = frame->frames + 1;
+
+	if (frame->swapped) {
+		/* Every refresh in between showed the previous list again. */
+		if (frames - frame->frames > 1)
+			st->dropped += frames - frame->frames - 1;
+
+		jitter = now_us - frame->swapped - frame->period;
+		jitter = jitter < 0 ? -jitter : jitter;
+
+		st->jitter_sum_us += jitter;
+
+		if (jitter > st->jitter_max_us)
+			st->jitter_max_us = jitter;
+	}
+
+	frame->swapped = now_us;
+	frame->frames = frames;
+
+	/* A list just got latched, render the next one right away. */
+	if (frame->next > now_us)
+		frame->next = now_us;
+}
+
+static void
+render(struct eve_frame *frame, int64_t now_us)
+{
+	struct eve_dl *dl = &frame->bufs[(frame->head + frame->count) % frame->nbufs];
+
+	eve_dl_init(dl);
+	frame->render(frame->arg, dl, frame->stats.rendered);
+	frame->count++;
+	frame->stats.rendered++;
+
+	frame->next += frame->period;
+
+	/* Too far behind, skip the slots already gone. */
+	while (frame->next <= now_us) {
+		frame->next += frame->period;
+		frame->stats.late++;
+	}
+}
+
+static void
+upload(struct eve_frame *frame)
+{
+	const struct eve_dl *dl = &frame->bufs[frame->head];
+
+	frame->head = (frame->head + 1) % frame->nbufs;
+	frame->count--;
+
+	if (eve_dl_swap_delta(frame->devc, &frame->shadow, dl) < 0) {
+		frame->stats.errors++;
+		return;
+	}
+
+	frame->pending = 1;
+	frame->stats.shown++;
+}
+
+int64_t
+eve_frame_period_us(uint32_t hcycle, uint32_t vcycle, uint32_t pclk, uint32_t freq)
+{
+	if (!freq)
+		return 0;
+
+	return (int64_t)hcycle * vcycle * pclk * 1000000 / freq;
+}
+
+int
+eve_frame_init(struct eve_frame *frame,
+               intptr_t devc,
+               size_t nbufs,
+               int64_t period_us,
+               eve_frame_render_t render,
+               void *arg,
+               int64_t now_us)
+{
+	assert(frame);
+	assert(render);
+
+	if (nbufs < 2 || nbufs > EVE_FRAME_BUFS_MAX || period_us <= 0)
+		return -1;
+
+	memset(frame, 0, offsetof(struct eve_frame, shadow));
+	eve_dl_shadow_init(&frame->shadow);
+	frame->devc = devc;
+	frame->render = render;
+	frame->arg = arg;
+	frame->period = period_us;
+	frame->next = now_us;
+	frame->nbufs = nbufs;
+
+	/* Drop SWAP events of earlier swaps, the splash one in particular. */
+	eve_irq_wait(devc, EVE_IRQ_SWAP, 0);
+
+	return 0;
+}
+
+int64_t
+eve_frame_step(struct eve_frame *frame, int64_t now_us)
+{
+	assert(frame);
+
+	int64_t delay;
+
+	if (frame->pending && swap_done(frame))
+		swap_complete(frame, now_us);
+
+	if (!frame->pending && frame->count)
+		upload(frame);
+
+	/* Without a free list the render waits for the next swap. */
+	if (now_us >= frame->next && frame->count < frame->nbufs)
+		render(frame, now_us);
+
+	if (!frame->pending && frame->count)
+		upload(frame);
+
+	delay = frame->next - now_us;
+
+	/* Swap completion has to be polled without interrupts. */
+	if (delay <= 0 || (frame->pending && !frame->irq && delay > EVE_FRAME_POLL_US))
+		delay = EVE_FRAME_POLL_US;
+
+	return delay;
+}
+
+void
+eve_frame_resume(struct eve_frame *frame, int64_t now_us)
+{
+	assert(frame);
+
+	frame->next = now_us;
+	frame->swapped = 0;
+
+	/* Stale events dropped, a pending swap is checked on the register. */
+	eve_irq_wait(frame->devc, EVE_IRQ_SWAP, 0);
+	frame->swap_irq = frame->pending;
+}
+
+int
+eve_frame_wait(struct eve_frame *frame, int64_t delay_us)
+{
+	assert(frame);
+
+	uint32_t timeout_ms = (delay_us + 999) / 1000;
+	int rc;
+
+	if (!frame->pending || !frame->irq)
+		return -1;
+
+	rc = eve_irq_wait(frame->devc, EVE_IRQ_SWAP, timeout_ms ? timeout_ms : 1);
+
+	if (rc < 0)
+		return -1;
+	if (rc > 0)
+		frame->swap_irq = 1;
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#ifndef EVE_FRAME_H
+#define EVE_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "eve.h"
+
+/*
+ * Display list scheduler paced to the panel refresh.
+ *
+ * The application renders into host side lists from a callback invoked each
+ * time a swap completes, or once per refresh period if swaps don't complete
+ * in time. Rendered lists wait in a FIFO and the oldest one is uploaded to
+ * RAM_DL only once the previous swap completed, so the list the device is
+ * about to show is never overwritten. Swaps are requested on frame
+ * boundaries to avoid tearing.
+ *
+ * Lists are uploaded with eve_dl_swap_delta, only the words that changed
+ * since the list last held by the same RAM_DL buffer are sent. Anything else
+ * writing RAM_DL while the scheduler runs must call eve_dl_shadow_init on
+ * frame->shadow.
+ *
+ * Like eve_boot the caller owns the clock and the waiting: eve_frame_step
+ * does what is due at now_us and tells how long to sleep.
+ *
+ * Completion relies on EVE_IRQ_SWAP when the platform has an interrupt line,
+ * it must then be part of the mask given to eve_irq_enable.
+ */
+
+/*
+ * Maximum number of host side display lists.
+ */
+#ifndef EVE_FRAME_BUFS_MAX
+#       define EVE_FRAME_BUFS_MAX       3
+#endif
+
+/*
+ * Shortest delay returned while a swap is pending and has to be polled.
+ */
+#ifndef EVE_FRAME_POLL_US
+#       define EVE_FRAME_POLL_US        1000
+#endif
+
+/**
+ * Fill dl, already initialized, with the list for the given frame number.
+ */
+typedef void (*eve_frame_render_t)(void *arg, struct eve_dl *dl, uint32_t frame);
+
+struct eve_frame_stats {
+	uint32_t rendered;              /* lists produced */
+	uint32_t shown;                 /* lists swapped in */
+	uint32_t late;                  /* render slots missed entirely */
+	uint32_t dropped;               /* refreshes repeating the previous list */
+	uint32_t errors;                /* failed uploads */
+	int64_t jitter_max_us;          /* worst swap interval deviation */
+	int64_t jitter_sum_us;          /* over shown - 1 intervals */
+};
+
+struct eve_frame {
+	intptr_t devc;
+	eve_frame_render_t render;
+	void *arg;
+	int64_t period;
+	int64_t next;                   /* next render */
+	int64_t swapped;                /* last swap completion, 0 if none */
+	uint32_t frames;                /* REG_FRAMES at that time */
+	int pending;                    /* swap requested, not done */
+	int irq;                        /* completion signalled by interrupt */
+	int swap_irq;                   /* REG_DLSWAP to be checked */
+	size_t nbufs;
+	size_t head;                    /* oldest rendered list */
+	size_t count;                   /* rendered lists waiting */
+	struct eve_frame_stats stats;
+	struct eve_dl_shadow shadow;    /* RAM_DL content, bytes sent */
+	struct eve_dl bufs[EVE_FRAME_BUFS_MAX];
+};
+
+/**
+ * Refresh period in microseconds for the given display timings and system
+ * clock (REG_FREQUENCY).
+ */
+int64_t
+eve_frame_period_us(uint32_t hcycle, uint32_t vcycle, uint32_t pclk, uint32_t freq);
+
+/**
+ * Use nbufs (2 or 3) host lists, the first render is due at now_us.
+ */
+int
+eve_frame_init(struct eve_frame *frame,
+               intptr_t devc,
+               size_t nbufs,
+               int64_t period_us,
+               eve_frame_render_t render,
+               void *arg,
+               int64_t now_us);
+
+/**
+ * Check swap completion, render if due and upload the next list if the
+ * device is ready.
+ *
+ * Returns the delay in microseconds before the next call.
+ */
+int64_t
+eve_frame_step(struct eve_frame *frame, int64_t now_us);
+
+/**
+ * Resume after eve_frame_step wasn't called for a while, the device being
+ * asleep: the next render is due at now_us and the pause counts neither as
+ * late slots nor as swap jitter.
+ */
+void
+eve_frame_resume(struct eve_frame *frame, int64_t now_us);
+
+/**
+ * Sleep for up to delay_us but wake up as soon as the pending swap completes.
+ *
+ * Returns -1 without waiting if there is no swap pending or no interrupt to
+ * wait on, the caller sleeps on its own then.
+ */
+int
+eve_frame_wait(struct eve_frame *frame, int64_t delay_us);
+
+#endif /* !EVE_FRAME_H */
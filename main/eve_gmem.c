@@ -0,0 +1,269 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_gmem.h"
+
+#define FREE            (-1)
+#define ALIGN(v, a)     (((v) + (a) - 1) & ~((a) - 1))
+
+static void
+block_insert(struct eve_gmem *gm, size_t i, uint32_t address, uint32_t size)
+{
+	memmove(&gm->blocks[i + 1], &gm->blocks[i], (gm->blocksz - i) * sizeof (gm->blocks[0]));
+
+	gm->blocks[i].address = address;
+	gm->blocks[i].size = size;
+	gm->blocks[i].id = FREE;
+	gm->blocksz++;
+}
+
+static void
+block_remove(struct eve_gmem *gm, size_t i)
+{
+	memmove(&gm->blocks[i], &gm->blocks[i + 1], (gm->blocksz - i - 1) * sizeof (gm->blocks[0]));
+	gm->blocksz--;
+}
+
+/*
+ * Merge the free block at index i with its free neighbours.
+ */
+static void
+block_coalesce(struct eve_gmem *gm, size_t i)
+{
+	if (i + 1 < gm->blocksz && gm->blocks[i + 1].id == FREE) {
+		gm->blocks[i].size += gm->blocks[i + 1].size;
+		block_remove(gm, i + 1);
+	}
+	if (i > 0 && gm->blocks[i - 1].id == FREE) {
+		gm->blocks[i - 1].size += gm->blocks[i].size;
+		block_remove(gm, i);
+	}
+}
+
+static int
+slot_get(struct eve_gmem *gm)
+{
+	for (int i = 0; i < EVE_GMEM_HANDLE_MAX; ++i)
+		if (!gm->slots[i].used)
+			return i;
+
+	return -1;
+}
+
+void
+eve_gmem_init(struct eve_gmem *gm, uint32_t base, uint32_t size)
+{
+	assert(gm);
+	assert(base + size <= EVE_MAP_RAM_G + EVE_GMEM_SIZE);
+
+	memset(gm, 0, sizeof (*gm));
+
+	gm->base = base;
+	gm->size = size;
+	gm->blocksz = 1;
+	gm->blocks[0].address = base;
+	gm->blocks[0].size = size;
+	gm->blocks[0].id = FREE;
+}
+
+int
+eve_gmem_alloc(struct eve_gmem *gm, uint32_t size, uint32_t align)
+{
+	assert(gm);
+	assert(align == 0 || (align & (align - 1)) == 0);
+
+	struct eve_gmem_block *block;
+	uint32_t start, need;
+	int id;
+
+	if (align < 4)
+		align = 4;
+	if (size == 0 || (id = slot_get(gm)) < 0)
+		return -1;
+
+	size = ALIGN(size, 4);
+
+	for (size_t i = 0; i < gm->blocksz; ++i) {
+		block = &gm->blocks[i];
+
+		if (block->id != FREE)
+			continue;
+
+		/* Alignment padding is kept inside the block. */
+		start = ALIGN(block->address, align);
+		need = (start - block->address) + size;
+
+		if (need > block->size)
+			continue;
+
+		/* Split remaining space into a new free block if possible. */
+		if (need < block->size) {
+			if (gm->blocksz == EVE_GMEM_BLOCK_MAX)
+				continue;
+
+			block_insert(gm, i + 1, block->address + need, block->size - need);
+			block->size = need;
+		}
+
+		block->id = id;
+		gm->slots[id].used = 1;
+		gm->slots[id].address = start;
+		gm->slots[id].size = size;
+		gm->slots[id].align = align;
+		gm->slots[id].bitmap = EVE_GMEM_NO_BITMAP;
+
+		return id;
+	}
+
+	return -1;
+}
+
+void
+eve_gmem_free(struct eve_gmem *gm, int id)
+{
+	assert(gm);
+	assert(id >= 0 && id < EVE_GMEM_HANDLE_MAX && gm->slots[id].used);
+
+	for (size_t i = 0; i < gm->blocksz; ++i) {
+		if (gm->blocks[i].id == id) {
+			gm->blocks[i].id = FREE;
+			block_coalesce(gm, i);
+			break;
+		}
+	}
+
+	memset(&gm->slots[id], 0, sizeof (gm->slots[id]));
+}
+
+uint32_t
+eve_gmem_address(const struct eve_gmem *gm, int id)
+{
+	assert(gm);
+	assert(id >= 0 && id < EVE_GMEM_HANDLE_MAX && gm->slots[id].used);
+
+	return gm->slots[id].address;
+}
+
+void
+eve_gmem_bind(struct eve_gmem *gm, int id, int bitmap)
+{
+	assert(gm);
+	assert(id >= 0 && id < EVE_GMEM_HANDLE_MAX && gm->slots[id].used);
+	assert(bitmap == EVE_GMEM_NO_BITMAP || (bitmap >= 0 && bitmap < 32));
+
+	gm->slots[id].bitmap = bitmap;
+}
+
+int
+eve_gmem_source(const struct eve_gmem *gm, int id, struct eve_dl *dl)
+{
+	assert(gm);
+	assert(id >= 0 && id < EVE_GMEM_HANDLE_MAX && gm->slots[id].used);
+
+	if (gm->slots[id].bitmap == EVE_GMEM_NO_BITMAP)
+		return -1;
+
+	eve_dl_bitmap_handle(dl, gm->slots[id].bitmap);
+	eve_dl_bitmap_source(dl, gm->slots[id].address);
+
+	return 0;
+}
+
+int
+eve_gmem_compact(struct eve_gmem *gm, struct eve_cp *cp)
+{
+	assert(gm);
+	assert(cp);
+
+	struct eve_gmem_slot *slot;
+	uint32_t moved[EVE_GMEM_HANDLE_MAX];
+	uint32_t next = gm->base, dest, src, num, len;
+	size_t n = 0;
+	int id;
+
+	/* Moves are planned and issued, the table is left alone until done. */
+	for (size_t i = 0; i < gm->blocksz; ++i) {
+		if ((id = gm->blocks[i].id) == FREE)
+			continue;
+
+		slot = &gm->slots[id];
+		moved[id] = ALIGN(next, slot->align);
+
+		/*
+		 * Regions only ever move down. When they overlap copy in
+		 * pieces no larger than the distance so each CMD_MEMCPY has
+		 * disjoint source and destination.
+		 */
+		for (dest = moved[id], src = slot->address, num = slot->size; src != dest && num; num -= len) {
+			len = src - dest < num ? src - dest : num;
+
+			if (eve_cp_memcpy(cp, dest, src, len) < 0)
+				goto stale;
+
+			dest += len;
+			src += len;
+		}
+
+		next = moved[id] + slot->size;
+	}
+
+	if (eve_cp_wait(cp) < 0)
+		goto stale;
+
+	/* Every copy executed, rebuild the table in place. */
+	next = gm->base;
+
+	for (size_t i = 0; i < gm->blocksz; ++i) {
+		if ((id = gm->blocks[i].id) == FREE)
+			continue;
+
+		slot = &gm->slots[id];
+
+		gm->blocks[n].address = next;
+		gm->blocks[n].size = (moved[id] - next) + slot->size;
+		gm->blocks[n].id = id;
+		slot->address = moved[id];
+		next += gm->blocks[n++].size;
+	}
+
+	if (next < gm->base + gm->size) {
+		gm->blocks[n].address = next;
+		gm->blocks[n].size = gm->base + gm->size - next;
+		gm->blocks[n++].id = FREE;
+	}
+
+	gm->blocksz = n;
+
+	return 0;
+
+stale:
+	gm->stale = 1;
+
+	return -1;
+}
+
+void
+eve_gmem_stats(const struct eve_gmem *gm, struct eve_gmem_stats *st)
+{
+	assert(gm);
+	assert(st);
+
+	memset(st, 0, sizeof (*st));
+
+	for (size_t i = 0; i < gm->blocksz; ++i) {
+		if (gm->blocks[i].id == FREE) {
+			st->free += gm->blocks[i].size;
+			st->holes++;
+
+			if (gm->blocks[i].size > st->largest)
+				st->largest = gm->blocks[i].size;
+		} else {
+			st->used += gm->blocks[i].size;
+			st->allocations++;
+		}
+	}
+
+	if (st->free)
+		st->fragmentation = 100 - (unsigned int)((uint64_t)st->largest * 100 / st->free);
+}
@@ -0,0 +1,130 @@
+#ifndef EVE_GMEM_H
+#define EVE_GMEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Host side allocator for EVE_MAP_RAM_G.
+ *
+ * The device memory is described as a list of blocks sorted by address, each
+ * either free or owning one allocation. Allocations are referred to by a
+ * small integer handle that stays valid when eve_gmem_compact moves the data
+ * around, so callers must always query the current address through
+ * eve_gmem_address rather than keeping it.
+ */
+
+struct eve_cp;
+struct eve_dl;
+
+/* Size of RAM_G in bytes. */
+#define EVE_GMEM_SIZE                   (1024U * 1024U)
+
+/*
+ * Maximum number of blocks (free and used) tracked by the allocator.
+ */
+#ifndef EVE_GMEM_BLOCK_MAX
+#       define EVE_GMEM_BLOCK_MAX       64
+#endif
+
+/*
+ * Maximum number of live allocations.
+ */
+#ifndef EVE_GMEM_HANDLE_MAX
+#       define EVE_GMEM_HANDLE_MAX      32
+#endif
+
+/*
+ * Value of eve_gmem_slot.bitmap when no bitmap handle is bound.
+ */
+#define EVE_GMEM_NO_BITMAP              (-1)
+
+struct eve_gmem_block {
+	uint32_t address;
+	uint32_t size;
+	int id;
+};
+
+struct eve_gmem_slot {
+	int used;
+	uint32_t address;
+	uint32_t size;
+	uint32_t align;
+	int bitmap;
+};
+
+struct eve_gmem {
+	uint32_t base;
+	uint32_t size;
+	size_t blocksz;
+	int stale;                      /* content lost, see eve_gmem_compact */
+	struct eve_gmem_block blocks[EVE_GMEM_BLOCK_MAX];
+	struct eve_gmem_slot slots[EVE_GMEM_HANDLE_MAX];
+};
+
+struct eve_gmem_stats {
+	uint32_t used;
+	uint32_t free;
+	uint32_t largest;
+	size_t allocations;
+	size_t holes;
+
+	/* 0 when all free memory is contiguous, up to 100. */
+	unsigned int fragmentation;
+};
+
+/**
+ * Manage size bytes of RAM_G starting at base.
+ */
+void
+eve_gmem_init(struct eve_gmem *gm, uint32_t base, uint32_t size);
+
+/**
+ * Allocate size bytes aligned to align (power of two, at least 4).
+ *
+ * Returns a handle or -1 if no free block is large enough, in which case
+ * eve_gmem_compact may help.
+ */
+int
+eve_gmem_alloc(struct eve_gmem *gm, uint32_t size, uint32_t align);
+
+void
+eve_gmem_free(struct eve_gmem *gm, int id);
+
+/**
+ * Current device address of the allocation.
+ */
+uint32_t
+eve_gmem_address(const struct eve_gmem *gm, int id);
+
+/**
+ * Associate the allocation with an EVE bitmap handle (0-31).
+ */
+void
+eve_gmem_bind(struct eve_gmem *gm, int id, int bitmap);
+
+/**
+ * Emit BITMAP_HANDLE and BITMAP_SOURCE for the allocation into dl.
+ */
+int
+eve_gmem_source(const struct eve_gmem *gm, int id, struct eve_dl *dl);
+
+/**
+ * Move every allocation to the start of the managed area with CMD_MEMCPY so
+ * that free memory becomes one block.
+ *
+ * Commands are queued into cp and the function waits for the coprocessor to
+ * complete. Display lists referencing moved allocations must be rebuilt.
+ *
+ * The allocations only get their new addresses once every copy completed.
+ * On failure they keep the old ones but some may have been partially
+ * overwritten: stale is set, the content of every allocation is undefined
+ * and must be uploaded again before the caller clears it.
+ */
+int
+eve_gmem_compact(struct eve_gmem *gm, struct eve_cp *cp);
+
+void
+eve_gmem_stats(const struct eve_gmem *gm, struct eve_gmem_stats *st);
+
+#endif /* !EVE_GMEM_H */
@@ -0,0 +1,258 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_idle.h"
+
+/* DISP is driven by bit 7 of REG_GPIO. */
+#define GPIO_DISP       0x80
+
+enum {
+	PANEL_PCLK,
+	PANEL_GPIO,
+	PANEL_DUTY,
+	PANEL_REGS
+};
+
+static void
+idle_enter(struct eve_idle *idle, enum eve_idle_state state, int64_t now_us)
+{
+	idle->stats.time_us[idle->state] += now_us - idle->since;
+	idle->stats.entered[state]++;
+	idle->state = state;
+	idle->since = now_us;
+}
+
+static int
+idle_writev(struct eve_idle *idle, const struct eve_reg *regs)
+{
+	struct eve_reg copy[PANEL_REGS];
+
+	/* Sorted in place by eve_writev. */
+	memcpy(copy, regs, sizeof (copy));
+
+	if (eve_writev(idle->devc, copy, PANEL_REGS) < 0) {
+		idle->stats.errors++;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Backlight, DISP and PCLK off, the panel stops being refreshed.
+ */
+static int
+idle_panel_off(struct eve_idle *idle)
+{
+	struct eve_reg regs[PANEL_REGS];
+
+	memcpy(regs, idle->panel, sizeof (regs));
+	regs[PANEL_PCLK].value = 0;
+	regs[PANEL_GPIO].value &= ~GPIO_DISP;
+	regs[PANEL_DUTY].value = 0;
+
+	return idle_writev(idle, regs);
+}
+
+static int
+idle_cmd(struct eve_idle *idle, uint8_t cmd)
+{
+	if (eve_cmd(idle->devc, cmd, 0) < 0) {
+		idle->stats.errors++;
+		return -1;
+	}
+
+	return 0;
+}
+
+static void
+idle_notify(struct eve_idle *idle, int awake)
+{
+	if (idle->notify)
+		idle->notify(idle->arg, awake);
+}
+
+static void
+idle_sleep(struct eve_idle *idle, enum eve_idle_state state, int64_t now_us)
+{
+	/* Users of the device stop before it becomes unreachable. */
+	if (state >= EVE_IDLE_STANDBY && idle->state < EVE_IDLE_STANDBY)
+		idle_notify(idle, 0);
+
+	switch (state) {
+	case EVE_IDLE_DIM:
+		if (eve_write8(idle->devc, EVE_REG_PWM_DUTY, idle->dim_duty) < 0)
+			idle->stats.errors++;
+		break;
+	case EVE_IDLE_STANDBY:
+		idle_panel_off(idle);
+		idle_cmd(idle, EVE_CMD_STANDBY);
+		break;
+	case EVE_IDLE_SLEEP:
+		/* Back through active, immediate as the clock is still running. */
+		if (idle->state == EVE_IDLE_STANDBY)
+			idle_cmd(idle, EVE_CMD_ACTIVE);
+		else
+			idle_panel_off(idle);
+		idle_cmd(idle, EVE_CMD_SLEEP);
+		break;
+	default:
+		break;
+	}
+
+	idle_enter(idle, state, now_us);
+}
+
+/*
+ * Poll REG_ID until the device answers then restore the panel, returns 1
+ * while still waiting.
+ */
+static int
+idle_wake(struct eve_idle *idle, int64_t now_us)
+{
+	int64_t latency;
+	uint8_t id;
+
+	if (eve_read8(idle->devc, EVE_REG_ID, &id) < 0 || id != EVE_ID) {
+		if (now_us >= idle->deadline) {
+			idle->stats.errors++;
+			idle->deadline = now_us + EVE_IDLE_WAKE_TIMEOUT_US;
+			idle_cmd(idle, EVE_CMD_ACTIVE);
+		}
+
+		return 1;
+	}
+
+	idle_writev(idle, idle->panel);
+	idle_enter(idle, EVE_IDLE_ACTIVE, now_us);
+
+	latency = now_us - idle->woken;
+
+	idle->stats.wakes++;
+	idle->stats.wake_last_us = latency;
+	idle->stats.wake_sum_us += latency;
+
+	if (latency > idle->stats.wake_max_us)
+		idle->stats.wake_max_us = latency;
+
+	idle_notify(idle, 1);
+
+	return 0;
+}
+
+int
+eve_idle_init(struct eve_idle *idle,
+              intptr_t devc,
+              int64_t dim_us,
+              int64_t standby_us,
+              int64_t sleep_us,
+              uint8_t dim_duty,
+              eve_idle_notify_t notify,
+              void *arg,
+              int64_t now_us)
+{
+	assert(idle);
+
+	static const uint32_t regs[PANEL_REGS] = {
+		[PANEL_PCLK] = EVE_REG_PCLK,
+		[PANEL_GPIO] = EVE_REG_GPIO,
+		[PANEL_DUTY] = EVE_REG_PWM_DUTY,
+	};
+	uint8_t value;
+
+	memset(idle, 0, sizeof (*idle));
+	idle->devc = devc;
+	idle->notify = notify;
+	idle->arg = arg;
+	idle->last = now_us;
+	idle->since = now_us;
+	idle->stats.entered[EVE_IDLE_ACTIVE] = 1;
+
+	/* Stays active for good if there's nothing to restore. */
+	for (size_t i = 0; i < PANEL_REGS; ++i) {
+		if (eve_read8(devc, regs[i], &value) < 0)
+			return -1;
+
+		idle->panel[i].address = regs[i];
+		idle->panel[i].value = value;
+	}
+
+	idle->after[EVE_IDLE_DIM] = dim_us;
+	idle->after[EVE_IDLE_STANDBY] = standby_us;
+	idle->after[EVE_IDLE_SLEEP] = sleep_us;
+	idle->dim_duty = dim_duty;
+
+	return 0;
+}
+
+int
+eve_idle_activity(struct eve_idle *idle, int64_t now_us)
+{
+	assert(idle);
+
+	idle->last = now_us;
+
+	switch (idle->state) {
+	case EVE_IDLE_DIM:
+		idle_enter(idle, EVE_IDLE_ACTIVE, now_us);
+
+		if (eve_write8(idle->devc, EVE_REG_PWM_DUTY, idle->panel[PANEL_DUTY].value) < 0) {
+			idle->stats.errors++;
+			return -1;
+		}
+		break;
+	case EVE_IDLE_STANDBY:
+	case EVE_IDLE_SLEEP:
+		idle_enter(idle, EVE_IDLE_WAKING, now_us);
+		idle->woken = now_us;
+		idle->deadline = now_us + EVE_IDLE_WAKE_TIMEOUT_US;
+
+		return idle_cmd(idle, EVE_CMD_ACTIVE);
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+int64_t
+eve_idle_step(struct eve_idle *idle, int64_t now_us)
+{
+	assert(idle);
+
+	int64_t due;
+
+	if (idle->state == EVE_IDLE_WAKING && idle_wake(idle, now_us))
+		return EVE_IDLE_POLL_US;
+
+	for (int state = idle->state + 1; state <= EVE_IDLE_SLEEP; ++state) {
+		if (!idle->after[state])
+			continue;
+
+		due = idle->last + idle->after[state];
+
+		if (now_us < due)
+			return due - now_us;
+
+		idle_sleep(idle, state, now_us);
+	}
+
+	return 0;
+}
+
+int
+eve_idle_awake(const struct eve_idle *idle)
+{
+	return idle->state == EVE_IDLE_ACTIVE || idle->state == EVE_IDLE_DIM;
+}
+
+void
+eve_idle_stats(const struct eve_idle *idle, struct eve_idle_stats *stats, int64_t now_us)
+{
+	assert(idle);
+	assert(stats);
+
+	*stats = idle->stats;
+	stats->time_us[idle->state] += now_us - idle->since;
+}
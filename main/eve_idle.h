@@ -0,0 +1,138 @@
+#ifndef EVE_IDLE_H
+#define EVE_IDLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "eve.h"
+
+/*
+ * Idle power management.
+ *
+ * Without activity the display goes through deeper and deeper states, each
+ * after its own delay counted from the last activity:
+ *
+ * - dim: the backlight is lowered, everything else keeps running;
+ * - standby: backlight, DISP and PCLK off then EVE_CMD_STANDBY, the core
+ *   clock is gated but the oscillator and PLL keep running;
+ * - sleep: EVE_CMD_SLEEP, the oscillator and PLL are off too.
+ *
+ * Registers, RAM_G and RAM_DL are retained in standby and sleep, waking up
+ * doesn't need init_lcd again: EVE_CMD_ACTIVE, REG_ID polled until the
+ * clock is back and one eve_writev restoring PCLK, GPIO and PWM_DUTY. The
+ * last list shown is in RAM_DL so it is scanned out on the first refresh,
+ * before anything is rendered. EVE_CMD_PWRDOWN and the PD pin lose all of
+ * it and are not used.
+ *
+ * The device can't be accessed while in standby or sleep, the caller stops
+ * rendering, audio and touch sampling until eve_idle_awake. The notify
+ * callback tells when: it runs before the panel is turned off and the host
+ * command is sent, so that other tasks polling the device (touch) are
+ * stopped first, and again once the panel is restored. The touch engine
+ * doesn't run either, touches only count as activity while active or
+ * dimmed, waking from deeper states is up to the host.
+ *
+ * Like eve_boot the caller owns the clock and the waiting.
+ */
+
+/*
+ * REG_ID polling interval while waking up and how long before EVE_CMD_ACTIVE
+ * is sent again.
+ */
+#ifndef EVE_IDLE_POLL_US
+#       define EVE_IDLE_POLL_US         1000
+#endif
+
+#ifndef EVE_IDLE_WAKE_TIMEOUT_US
+#       define EVE_IDLE_WAKE_TIMEOUT_US 100000
+#endif
+
+/**
+ * The device is about to become unreachable (awake 0) or is back (awake 1).
+ */
+typedef void (*eve_idle_notify_t)(void *arg, int awake);
+
+enum eve_idle_state {
+	EVE_IDLE_ACTIVE,
+	EVE_IDLE_DIM,
+	EVE_IDLE_STANDBY,
+	EVE_IDLE_SLEEP,
+	EVE_IDLE_WAKING,                /* waiting for REG_ID */
+	EVE_IDLE_NSTATES
+};
+
+struct eve_idle_stats {
+	int64_t time_us[EVE_IDLE_NSTATES];   /* spent in each state */
+	uint32_t entered[EVE_IDLE_NSTATES];
+	uint32_t wakes;                 /* from standby or sleep */
+	uint32_t errors;                /* failed transfers, wake retries */
+	int64_t wake_last_us;           /* ACTIVE sent to registers restored */
+	int64_t wake_max_us;
+	int64_t wake_sum_us;            /* over wakes */
+};
+
+struct eve_idle {
+	intptr_t devc;
+	enum eve_idle_state state;
+	int64_t after[EVE_IDLE_SLEEP + 1];   /* delay per state, 0 if skipped */
+	int64_t last;                   /* last activity */
+	int64_t since;                  /* state entered */
+	int64_t woken;                  /* EVE_CMD_ACTIVE sent */
+	int64_t deadline;               /* EVE_CMD_ACTIVE sent again */
+	uint8_t dim_duty;
+	eve_idle_notify_t notify;
+	void *arg;
+	struct eve_reg panel[3];        /* PCLK, GPIO and PWM_DUTY when active */
+	struct eve_idle_stats stats;
+};
+
+/**
+ * Start active at now_us, the display must be fully set up: PCLK, GPIO and
+ * PWM_DUTY are read back to be restored on wake.
+ *
+ * Each delay is the inactivity before entering the state, 0 skips it.
+ * dim_duty is the PWM_DUTY while dimmed. notify may be NULL. On failure the
+ * display stays active.
+ */
+int
+eve_idle_init(struct eve_idle *idle,
+              intptr_t devc,
+              int64_t dim_us,
+              int64_t standby_us,
+              int64_t sleep_us,
+              uint8_t dim_duty,
+              eve_idle_notify_t notify,
+              void *arg,
+              int64_t now_us);
+
+/**
+ * Record activity at now_us, the display is brought back to active.
+ *
+ * From standby or sleep waking up continues in eve_idle_step, which should
+ * be called next.
+ */
+int
+eve_idle_activity(struct eve_idle *idle, int64_t now_us);
+
+/**
+ * Enter the states due at now_us or progress waking up.
+ *
+ * Returns the delay in microseconds before the next call or 0 if nothing
+ * happens until the next activity.
+ */
+int64_t
+eve_idle_step(struct eve_idle *idle, int64_t now_us);
+
+/**
+ * Whether the device can be accessed, active or dimmed.
+ */
+int
+eve_idle_awake(const struct eve_idle *idle);
+
+/**
+ * Statistics with the time in the current state accounted up to now_us.
+ */
+void
+eve_idle_stats(const struct eve_idle *idle, struct eve_idle_stats *stats, int64_t now_us);
+
+#endif /* !EVE_IDLE_H */
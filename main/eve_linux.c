@@ -0,0 +1,852 @@
+#if defined(EVE_LINUX)
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_linux.h"
+
+#define DEVC(s)         ((struct devc *)(s))
+
+#define RAM_G_SIZE      (1024U * 1024U)
+#define RAM_REG_SIZE    4096U
+
+/* Offset of a register in the register file. */
+#define REG(r)          ((r) & 0xfff)
+
+/* Value of REG_CMD_READ once the coprocessor faulted. */
+#define CP_FAULT        0xfff
+
+/*
+ * Bytes sent besides the data: the 24-bit address, reads add a dummy byte
+ * and host commands are always 3 bytes long.
+ */
+#define HDR_WRITE       3
+#define HDR_READ        4
+#define HDR_CMD         3
+
+/* Frame period until the display timings are programmed, 60Hz. */
+#define FRAME_NS        16666667ULL
+
+/* ROM font metric blocks, fonts 16 to 31. */
+#define ROM_FONTS       0x00201ee0U
+#define ROM_FONT_SIZE   148U
+#define ROM_FONT_COUNT  16U
+
+/* Oscillator and PLL restart after EVE_CMD_ACTIVE from sleep. */
+#define SLEEP_WAKE_NS   20000000ULL
+
+/* REG_FREQUENCY after reset. */
+#define FREQUENCY       60000000U
+
+/*
+ * Registers are kept in host order in the register file which is fine as
+ * long as the host is little endian like the device.
+ */
+struct devc {
+	struct eve eve;
+	int64_t clk;
+	int32_t latency_ns;
+	int width;
+	int width_max;
+	int powered;
+	int active;
+	int sleeping;                   /* clock stopped by EVE_CMD_SLEEP */
+	uint64_t wake_ns;               /* clock back from sleep */
+	uint64_t time_ns;
+
+	/*
+	 * Coprocessor parser, commands are consumed a word at a time so
+	 * partially written commands are resumed on the next write.
+	 */
+	uint16_t cmd_read;
+	uint16_t cmd_write;
+	int fault;
+	uint32_t op;
+	uint32_t args[4];
+	int nargs;
+	int want;
+	uint32_t stream_ptr;
+	uint32_t stream_left;
+	int string;
+
+	struct eve_linux_stats stats;
+
+	int playback;                   /* audio engine running */
+	uint64_t playback_ns;           /* since */
+
+	uint8_t *flash;                 /* erased to 0xff, NULL if none */
+	uint32_t flash_size;
+
+	uint8_t ram_g[RAM_G_SIZE];
+	uint8_t ram_dl[EVE_DL_SIZE];
+	uint8_t reg[RAM_REG_SIZE];
+	uint8_t rom_fonts[ROM_FONT_COUNT * ROM_FONT_SIZE + 4];
+	uint8_t cmd[EVE_CP_FIFO_SIZE];
+};
+
+/*
+ * Coprocessor commands understood by the simulator and their number of
+ * argument words, anything else faults the coprocessor. Commands taking
+ * compressed data can't be supported as the length is only known once
+ * decoded.
+ */
+static const struct {
+	uint32_t op;
+	int nargs;
+} cp_ops[] = {
+	{ EVE_CPC_DLSTART,   0 },
+	{ EVE_CPC_SWAP,      0 },
+	{ EVE_CPC_INTERRUPT, 1 },
+	{ EVE_CPC_TEXT,      2 },
+	{ EVE_CPC_MEMWRITE,  2 },
+	{ EVE_CPC_MEMSET,    3 },
+	{ EVE_CPC_MEMZERO,   2 },
+	{ EVE_CPC_MEMCPY,    3 },
+	{ EVE_CPC_APPEND,    2 },
+	{ EVE_CPC_COLDSTART, 0 },
+	{ EVE_CPC_FLASHATTACH, 0 },
+	{ EVE_CPC_FLASHDETACH, 0 },
+	{ EVE_CPC_FLASHFAST,   1 },
+	{ EVE_CPC_FLASHUPDATE, 3 },
+	{ EVE_CPC_FLASHREAD,   3 },
+	{ EVE_CPC_SNAPSHOT2,   4 },
+	{ EVE_CPC_SETFONT2,    3 },
+};
+
+static uint32_t
+eve__reg_get(struct devc *devc, uint32_t reg)
+{
+	uint32_t value;
+
+	memcpy(&value, &devc->reg[REG(reg)], 4);
+
+	return value;
+}
+
+static void
+eve__reg_set(struct devc *devc, uint32_t reg, uint32_t value)
+{
+	memcpy(&devc->reg[REG(reg)], &value, 4);
+}
+
+static int
+eve__covers(uint32_t address, size_t size, uint32_t reg)
+{
+	return address <= reg && reg < address + size;
+}
+
+static uint8_t *
+eve__map(struct devc *devc, uint32_t address, size_t size)
+{
+	if (address + size <= RAM_G_SIZE)
+		return &devc->ram_g[address];
+	if (address >= EVE_MAP_RAM_DL && address + size <= EVE_MAP_RAM_DL + EVE_DL_SIZE)
+		return &devc->ram_dl[address - EVE_MAP_RAM_DL];
+	if (address >= EVE_MAP_RAM_REG && address + size <= EVE_MAP_RAM_REG + RAM_REG_SIZE)
+		return &devc->reg[address - EVE_MAP_RAM_REG];
+	if (address >= EVE_MAP_RAM_CMD && address + size <= EVE_MAP_RAM_CMD + EVE_CP_FIFO_SIZE)
+		return &devc->cmd[address - EVE_MAP_RAM_CMD];
+	if (address >= ROM_FONTS && address + size <= ROM_FONTS + ROM_FONT_COUNT * ROM_FONT_SIZE)
+		return &devc->rom_fonts[address - ROM_FONTS];
+	if (address == EVE_ROM_FONTROOT && size <= 4)
+		return &devc->rom_fonts[ROM_FONT_COUNT * ROM_FONT_SIZE];
+
+	return NULL;
+}
+
+/*
+ * ROM font metrics with the real line heights, widths are not modelled:
+ * every printable character is half the height wide, 8 pixels for the 8x8
+ * and 8x16 fonts.
+ */
+static void
+eve__rom_fonts(struct devc *devc)
+{
+	static const uint8_t heights[ROM_FONT_COUNT] = {
+		8, 8, 16, 16, 13, 17, 20, 22, 29, 38, 16, 20, 25, 28, 36, 49,
+	};
+	uint32_t root = ROM_FONTS, value;
+	uint8_t *block;
+
+	for (uint32_t i = 0; i < ROM_FONT_COUNT; ++i) {
+		block = &devc->rom_fonts[i * ROM_FONT_SIZE];
+		memset(block, 0, ROM_FONT_SIZE);
+		memset(&block[32], i < 4 ? 8 : heights[i] / 2, 96);
+
+		value = heights[i];
+		memcpy(&block[140], &value, 4);
+	}
+
+	memcpy(&devc->rom_fonts[ROM_FONT_COUNT * ROM_FONT_SIZE], &root, 4);
+}
+
+/*
+ * Account one transaction of n bytes on the wire, the address phase uses as
+ * many lines as the data.
+ */
+static void
+eve__charge(struct devc *devc, size_t n)
+{
+	uint64_t ns;
+
+	ns = devc->latency_ns + n * 8 * 1000000000ULL / (devc->clk * devc->width);
+
+	devc->time_ns += ns;
+	devc->stats.time_ns += ns;
+	devc->stats.bytes += n;
+	devc->stats.transactions++;
+}
+
+static uint64_t
+eve__frame_ns(struct devc *devc)
+{
+	uint64_t hcycle = eve__reg_get(devc, EVE_REG_HCYCLE) & 0xfff;
+	uint64_t vcycle = eve__reg_get(devc, EVE_REG_VCYCLE) & 0xfff;
+	uint64_t pclk = eve__reg_get(devc, EVE_REG_PCLK) & 0xff;
+	uint64_t freq = eve__reg_get(devc, EVE_REG_FREQUENCY);
+
+	if (!hcycle || !vcycle || !pclk || !freq)
+		return FRAME_NS;
+
+	return hcycle * vcycle * pclk * 1000000000ULL / freq;
+}
+
+static void
+eve__irq(struct devc *devc, uint8_t flags)
+{
+	eve__reg_set(devc, EVE_REG_INT_FLAGS, eve__reg_get(devc, EVE_REG_INT_FLAGS) | flags);
+}
+
+/* The scanout is not modelled, a swap is done as soon as requested. */
+static void
+eve__swap(struct devc *devc)
+{
+	eve__reg_set(devc, EVE_REG_DLSWAP, EVE_DLSWAP_DONE);
+	eve__irq(devc, EVE_IRQ_SWAP);
+	devc->stats.swaps++;
+}
+
+/*
+ * Move REG_PLAYBACK_READPTR along with time, samples themselves are not
+ * played.
+ */
+static void
+eve__playback(struct devc *devc)
+{
+	uint32_t start = eve__reg_get(devc, EVE_REG_PLAYBACK_START) & 0xfffff;
+	uint32_t length = eve__reg_get(devc, EVE_REG_PLAYBACK_LENGTH) & 0xfffff;
+	uint64_t freq = eve__reg_get(devc, EVE_REG_PLAYBACK_FREQ) & 0xffff;
+	uint64_t bytes;
+
+	/* The length may be zeroed to stop, the engine sees it on PLAY. */
+	if (!devc->playback || !length)
+		return;
+
+	bytes = (devc->time_ns - devc->playback_ns) * freq / 1000000000ULL;
+
+	if ((eve__reg_get(devc, EVE_REG_PLAYBACK_FORMAT) & 0x3) == EVE_SAMPLES_ADPCM)
+		bytes /= 2;
+
+	if (bytes >= length && eve__reg_get(devc, EVE_REG_PLAYBACK_LOOP) & 0x1) {
+		bytes %= length;
+	} else if (bytes >= length) {
+		bytes = length;
+		devc->playback = 0;
+		eve__reg_set(devc, EVE_REG_PLAYBACK_PLAY, 0);
+		eve__irq(devc, EVE_IRQ_PLAYBACK);
+	}
+
+	eve__reg_set(devc, EVE_REG_PLAYBACK_READPTR, (start + bytes) & 0xfffff);
+}
+
+/*
+ * A zero length stops the playback in progress.
+ */
+static void
+eve__play(struct devc *devc)
+{
+	eve__playback(devc);
+
+	devc->playback = (eve__reg_get(devc, EVE_REG_PLAYBACK_LENGTH) & 0xfffff) != 0;
+	devc->playback_ns = devc->time_ns;
+
+	eve__reg_set(devc, EVE_REG_PLAYBACK_PLAY, devc->playback);
+	eve__reg_set(devc, EVE_REG_PLAYBACK_READPTR, eve__reg_get(devc, EVE_REG_PLAYBACK_START) & 0xfffff);
+}
+
+static void
+eve__cp_reset(struct devc *devc)
+{
+	devc->cmd_read = 0;
+	devc->cmd_write = 0;
+	devc->fault = 0;
+	devc->op = 0;
+	devc->stream_left = 0;
+	devc->string = 0;
+	eve__reg_set(devc, EVE_REG_CMD_DL, 0);
+}
+
+static void
+eve__reset(struct devc *devc)
+{
+	memset(devc->reg, 0, sizeof (devc->reg));
+	eve__reg_set(devc, EVE_REG_FREQUENCY, FREQUENCY);
+	eve__cp_reset(devc);
+	devc->width = 1;
+	devc->playback = 0;
+}
+
+/*
+ * Refresh the registers derived from the simulator state before they are
+ * read.
+ */
+static void
+eve__sync(struct devc *devc)
+{
+	uint16_t used = (devc->cmd_write - devc->cmd_read) & 0xfff;
+	uint64_t us = devc->time_ns / 1000;
+
+	eve__reg_set(devc, EVE_REG_ID, EVE_ID);
+	eve__reg_set(devc, EVE_REG_FRAMES, devc->time_ns / eve__frame_ns(devc));
+	eve__reg_set(devc, EVE_REG_CLOCK, us * (eve__reg_get(devc, EVE_REG_FREQUENCY) / 1000) / 1000);
+	eve__reg_set(devc, EVE_REG_CMD_READ, devc->fault ? CP_FAULT : devc->cmd_read);
+	eve__reg_set(devc, EVE_REG_CMD_WRITE, devc->cmd_write);
+	/* Computed from REG_CMD_READ like on hardware, unaligned after a fault. */
+	eve__reg_set(devc,
+	             EVE_REG_CMDB_SPACE,
+	             devc->fault ? (CP_FAULT - devc->cmd_write - 4) & 0xfff : (EVE_CP_FIFO_SIZE - 4 - used) & 0xffc);
+	eve__playback(devc);
+}
+
+static int
+eve__cp_dl(struct devc *devc, const void *data, size_t size)
+{
+	uint32_t offset = eve__reg_get(devc, EVE_REG_CMD_DL) & 0x1fff;
+
+	if (offset + size > EVE_DL_SIZE)
+		return -1;
+
+	memcpy(&devc->ram_dl[offset], data, size);
+	eve__reg_set(devc, EVE_REG_CMD_DL, offset + size);
+
+	return 0;
+}
+
+/*
+ * Flash area of num bytes at address, NULL unless attached.
+ */
+static uint8_t *
+eve__flash(struct devc *devc, uint32_t address, uint32_t num)
+{
+	if (eve__reg_get(devc, EVE_REG_FLASH_STATUS) < EVE_FLASH_STATUS_BASIC)
+		return NULL;
+	if (address > devc->flash_size || num > devc->flash_size - address)
+		return NULL;
+
+	return &devc->flash[address];
+}
+
+/*
+ * The result replaces the argument word just consumed. Fast mode needs the
+ * blob, sector 0 must at least not be blank.
+ */
+static void
+eve__flash_fast(struct devc *devc)
+{
+	uint32_t status = eve__reg_get(devc, EVE_REG_FLASH_STATUS);
+	uint32_t result = 0xe001;
+	uint32_t blank = 0xffffffff;
+
+	if (status >= EVE_FLASH_STATUS_BASIC)
+		result = memcmp(devc->flash, &blank, 4) == 0 ? 0xe002 : 0;
+	if (result == 0)
+		eve__reg_set(devc, EVE_REG_FLASH_STATUS, EVE_FLASH_STATUS_FULL);
+
+	memcpy(&devc->cmd[(devc->cmd_read - 4) & 0xffc], &result, 4);
+}
+
+/*
+ * Only clears are rendered: the screen is the colour of the last CLEAR of
+ * the list being displayed.
+ */
+static uint32_t
+eve__screen_argb(struct devc *devc)
+{
+	uint32_t word, rgb = 0, a = 0, argb = 0;
+
+	for (size_t i = 0; i < EVE_DL_SIZE; i += 4) {
+		memcpy(&word, &devc->ram_dl[i], 4);
+
+		if (word == EVE_DLC_DISPLAY)
+			break;
+
+		if ((word & 0xff000000) == EVE_DLC_CLEAR_COLOR_RGB)
+			rgb = word & 0xffffff;
+		else if ((word & 0xff000000) == EVE_DLC_CLEAR_COLOR_A)
+			a = word & 0xff;
+		else if ((word & 0xff000000) == EVE_DLC_CLEAR && word & 0x4)
+			argb = a << 24 | rgb;
+	}
+
+	return argb;
+}
+
+static int
+eve__snapshot(struct devc *devc, uint32_t format, uint32_t ptr, uint16_t w, uint16_t h)
+{
+	uint32_t argb = eve__screen_argb(devc);
+	uint32_t r = argb >> 16 & 0xff, g = argb >> 8 & 0xff, b = argb & 0xff;
+	uint32_t pixel, bpp = 2, n;
+	uint8_t *dst;
+
+	if (format == EVE_FORMAT_RGB565)
+		pixel = (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+	else if (format == EVE_FORMAT_ARGB4)
+		pixel = (argb >> 28) << 12 | (r >> 4) << 8 | (g >> 4) << 4 | b >> 4;
+	else if (format == EVE_FORMAT_ARGB8_SNAPSHOT)
+		pixel = argb, bpp = 4, w /= 2;
+	else
+		return -1;
+
+	n = (uint32_t)w * h;
+
+	if (!(dst = eve__map(devc, ptr, n * bpp)))
+		return -1;
+
+	for (uint32_t i = 0; i < n; ++i)
+		memcpy(&dst[i * bpp], &pixel, bpp);
+
+	return 0;
+}
+
+static int
+eve__cp_exec(struct devc *devc)
+{
+	uint32_t *args = devc->args;
+	uint8_t *dst, *src;
+
+	switch (devc->op) {
+	case EVE_CPC_DLSTART:
+		eve__reg_set(devc, EVE_REG_CMD_DL, 0);
+		break;
+	case EVE_CPC_SWAP:
+		eve__swap(devc);
+		break;
+	case EVE_CPC_INTERRUPT:
+		eve__irq(devc, EVE_IRQ_CMDFLAG);
+		break;
+	case EVE_CPC_TEXT:
+		/* Nothing is rendered, only skip the string. */
+		devc->string = 1;
+		return 0;
+	case EVE_CPC_MEMWRITE:
+		devc->stream_ptr = args[0];
+		devc->stream_left = args[1];
+
+		if (devc->stream_left)
+			return 0;
+		break;
+	case EVE_CPC_MEMSET:
+	case EVE_CPC_MEMZERO:
+		if (devc->op == EVE_CPC_MEMZERO)
+			args[2] = args[1], args[1] = 0;
+		if (!(dst = eve__map(devc, args[0], args[2])))
+			return -1;
+
+		memset(dst, args[1], args[2]);
+		break;
+	case EVE_CPC_MEMCPY:
+		if (!(dst = eve__map(devc, args[0], args[2])) ||
+		    !(src = eve__map(devc, args[1], args[2])))
+			return -1;
+
+		memmove(dst, src, args[2]);
+		break;
+	case EVE_CPC_APPEND:
+		if (!(src = eve__map(devc, args[0], args[1])) ||
+		    eve__cp_dl(devc, src, args[1]) < 0)
+			return -1;
+		break;
+	case EVE_CPC_FLASHATTACH:
+		if (devc->flash && eve__reg_get(devc, EVE_REG_FLASH_STATUS) < EVE_FLASH_STATUS_BASIC)
+			eve__reg_set(devc, EVE_REG_FLASH_STATUS, EVE_FLASH_STATUS_BASIC);
+		break;
+	case EVE_CPC_FLASHDETACH:
+		eve__reg_set(devc, EVE_REG_FLASH_STATUS, EVE_FLASH_STATUS_DETACHED);
+		break;
+	case EVE_CPC_FLASHFAST:
+		eve__flash_fast(devc);
+		break;
+	case EVE_CPC_FLASHUPDATE:
+		if (args[0] % 4096 || args[2] % 4096 ||
+		    !(dst = eve__flash(devc, args[0], args[2])) ||
+		    !(src = eve__map(devc, args[1], args[2])))
+			return -1;
+
+		memcpy(dst, src, args[2]);
+		break;
+	case EVE_CPC_SNAPSHOT2:
+		if (eve__snapshot(devc, args[0], args[1], args[3] & 0xffff, args[3] >> 16) < 0)
+			return -1;
+		break;
+	case EVE_CPC_FLASHREAD:
+		if (!(dst = eve__map(devc, args[0], args[2])) ||
+		    !(src = eve__flash(devc, args[1], args[2])))
+			return -1;
+
+		memcpy(dst, src, args[2]);
+		break;
+	default:
+		break;
+	}
+
+	devc->op = 0;
+
+	return 0;
+}
+
+static int
+eve__cp_word(struct devc *devc, uint32_t word)
+{
+	uint8_t *dst;
+	size_t n;
+
+	if (devc->stream_left) {
+		n = devc->stream_left < 4 ? devc->stream_left : 4;
+
+		if (!(dst = eve__map(devc, devc->stream_ptr, n)))
+			return -1;
+
+		memcpy(dst, &word, n);
+		devc->stream_ptr += n;
+		devc->stream_left -= n;
+
+		if (!devc->stream_left)
+			devc->op = 0;
+
+		return 0;
+	}
+
+	if (devc->string) {
+		if (memchr(&word, 0, 4)) {
+			devc->string = 0;
+			devc->op = 0;
+		}
+		return 0;
+	}
+
+	if (devc->op) {
+		devc->args[devc->nargs++] = word;
+	} else if ((word & 0xffffff00) != 0xffffff00) {
+		return eve__cp_dl(devc, &word, 4);
+	} else {
+		size_t i;
+
+		for (i = 0; i < sizeof (cp_ops) / sizeof (cp_ops[0]); ++i)
+			if (cp_ops[i].op == word)
+				break;
+
+		if (i == sizeof (cp_ops) / sizeof (cp_ops[0]))
+			return -1;
+
+		devc->op = word;
+		devc->want = cp_ops[i].nargs;
+		devc->nargs = 0;
+	}
+
+	return devc->nargs < devc->want ? 0 : eve__cp_exec(devc);
+}
+
+/*
+ * Consume everything written so far, the coprocessor is infinitely fast
+ * compared to the link.
+ */
+static void
+eve__cp_run(struct devc *devc)
+{
+	uint32_t word;
+
+	while (!devc->fault && devc->cmd_read != devc->cmd_write) {
+		memcpy(&word, &devc->cmd[devc->cmd_read], 4);
+		devc->cmd_read = (devc->cmd_read + 4) & 0xfff;
+		devc->stats.cp_words++;
+
+		if (eve__cp_word(devc, word) < 0)
+			devc->fault = 1;
+	}
+
+	if (!devc->fault)
+		eve__irq(devc, EVE_IRQ_CMDEMPTY);
+}
+
+/*
+ * Whether the device answers on the bus, active with its clock running.
+ */
+static int
+eve__awake(struct devc *devc)
+{
+	return devc->active && devc->time_ns >= devc->wake_ns;
+}
+
+static int
+eve__read(struct eve *eve, uint32_t address, void *data, size_t size)
+{
+	struct devc *devc = DEVC(eve);
+	uint8_t *mem;
+
+	eve__charge(devc, HDR_READ + size);
+
+	/* Nobody drives MISO until the device is active. */
+	if (!eve__awake(devc)) {
+		memset(data, 0, size);
+		return 0;
+	}
+
+	if (!(mem = eve__map(devc, address, size)))
+		return -1;
+
+	eve__sync(devc);
+	memcpy(data, mem, size);
+
+	if (eve__covers(address, size, EVE_REG_INT_FLAGS))
+		eve__reg_set(devc, EVE_REG_INT_FLAGS, 0);
+
+	return 0;
+}
+
+static int
+eve__write(struct eve *eve, uint32_t address, const void *data, size_t size)
+{
+	struct devc *devc = DEVC(eve);
+	const uint8_t *buf = data;
+	uint8_t *mem;
+	uint32_t value;
+
+	eve__charge(devc, HDR_WRITE + size);
+
+	if (!eve__awake(devc))
+		return 0;
+
+	if (address == EVE_REG_CMDB_WRITE) {
+		eve__sync(devc);
+
+		if (size & 3 || size > eve__reg_get(devc, EVE_REG_CMDB_SPACE))
+			return -1;
+
+		for (size_t i = 0; i < size; ++i) {
+			devc->cmd[devc->cmd_write] = buf[i];
+			devc->cmd_write = (devc->cmd_write + 1) & 0xfff;
+		}
+
+		eve__cp_run(devc);
+
+		return 0;
+	}
+
+	if (!(mem = eve__map(devc, address, size)))
+		return -1;
+
+	memcpy(mem, data, size);
+
+	if (eve__covers(address, size, EVE_REG_CPURESET) &&
+	    eve__reg_get(devc, EVE_REG_CPURESET) & 0x1)
+		eve__cp_reset(devc);
+
+	if (eve__covers(address, size, EVE_REG_CMD_READ))
+		devc->cmd_read = eve__reg_get(devc, EVE_REG_CMD_READ) & 0xffc;
+
+	if (eve__covers(address, size, EVE_REG_CMD_WRITE)) {
+		devc->cmd_write = eve__reg_get(devc, EVE_REG_CMD_WRITE) & 0xffc;
+		eve__cp_run(devc);
+	}
+
+	if (eve__covers(address, size, EVE_REG_DLSWAP) &&
+	    eve__reg_get(devc, EVE_REG_DLSWAP) & 0x3)
+		eve__swap(devc);
+
+	if (eve__covers(address, size, EVE_REG_PLAYBACK_PLAY) &&
+	    eve__reg_get(devc, EVE_REG_PLAYBACK_PLAY) & 0x1)
+		eve__play(devc);
+
+	if (eve__covers(address, size, EVE_REG_SPI_WIDTH)) {
+		value = eve__reg_get(devc, EVE_REG_SPI_WIDTH) & 0x3;
+		devc->width = value == 2 ? 4 : value == 1 ? 2 : 1;
+	}
+
+	return 0;
+}
+
+static int
+eve__cmd(struct eve *eve, uint8_t cmd, uint8_t param)
+{
+	struct devc *devc = DEVC(eve);
+
+	eve__charge(devc, HDR_CMD);
+
+	if (!devc->powered)
+		return 0;
+
+	switch (cmd) {
+	case EVE_CMD_ACTIVE:
+		if (devc->sleeping)
+			devc->wake_ns = devc->time_ns + SLEEP_WAKE_NS;
+		devc->active = 1;
+		devc->sleeping = 0;
+		break;
+	case EVE_CMD_SLEEP:
+		devc->sleeping = 1;
+		devc->active = 0;
+		break;
+	case EVE_CMD_STANDBY:
+	case EVE_CMD_PWRDOWN:
+		devc->active = 0;
+		break;
+	case EVE_CMD_RST_PULSE:
+		eve__reset(devc);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static int
+eve__power(struct eve *eve, int enable)
+{
+	struct devc *devc = DEVC(eve);
+
+	if (!enable && devc->powered) {
+		memset(devc->ram_g, 0, sizeof (devc->ram_g));
+		memset(devc->ram_dl, 0, sizeof (devc->ram_dl));
+		memset(devc->cmd, 0, sizeof (devc->cmd));
+		eve__reset(devc);
+		devc->active = 0;
+		devc->sleeping = 0;
+	}
+
+	devc->powered = enable;
+
+	return 0;
+}
+
+static int
+eve__set_width(struct eve *eve, int width)
+{
+	uint8_t value;
+
+	switch (width) {
+	case 1:
+		value = 0;
+		break;
+	case 2:
+		value = 1;
+		break;
+	case 4:
+		value = 2;
+		break;
+	default:
+		return -1;
+	}
+
+	if (width > DEVC(eve)->width_max)
+		return -1;
+
+	return eve__write(eve, EVE_REG_SPI_WIDTH, &value, 1);
+}
+
+/*
+ * The host clock is the modelled one, waiting lets the device time pass.
+ */
+static int64_t
+eve__time(struct eve *eve)
+{
+	return DEVC(eve)->time_ns / 1000;
+}
+
+static void
+eve__sleep(struct eve *eve, uint32_t us)
+{
+	DEVC(eve)->time_ns += us * 1000ULL;
+}
+
+static void
+eve__finish(struct eve *eve)
+{
+	free(DEVC(eve)->flash);
+	free(DEVC(eve));
+}
+
+/*
+ * Without an interrupt line the wait functions poll registers, which costs
+ * transactions just like on hardware without INT wired.
+ */
+static const struct eve_ops ops = {
+	.read      = eve__read,
+	.write     = eve__write,
+	.cmd       = eve__cmd,
+	.power     = eve__power,
+	.set_width = eve__set_width,
+	.time      = eve__time,
+	.sleep     = eve__sleep,
+	.finish    = eve__finish,
+};
+
+intptr_t
+eve_init(const struct eve_cfg *cfg)
+{
+	assert(cfg);
+
+	struct devc *devc;
+
+	if (cfg->spi_clk_speed <= 0)
+		return -1;
+	if (!(devc = calloc(1, sizeof (*devc))))
+		return -1;
+
+	devc->clk = cfg->spi_clk_speed;
+	devc->latency_ns = cfg->latency_ns;
+	devc->width_max = cfg->spi_width >= 4 ? 4 : cfg->spi_width >= 2 ? 2 : 1;
+
+	if (cfg->flash_size) {
+		if (!(devc->flash = malloc(cfg->flash_size))) {
+			free(devc);
+			return -1;
+		}
+
+		memset(devc->flash, 0xff, cfg->flash_size);
+		devc->flash_size = cfg->flash_size;
+	}
+
+	devc->eve.ops = &ops;
+	eve__rom_fonts(devc);
+	eve__reset(devc);
+
+	return (intptr_t)&devc->eve;
+}
+
+int
+eve_linux_stats(intptr_t devc, struct eve_linux_stats *stats)
+{
+	assert(stats);
+
+	*stats = DEVC(devc)->stats;
+
+	return 0;
+}
+
+void
+eve_linux_stats_reset(intptr_t devc)
+{
+	memset(&DEVC(devc)->stats, 0, sizeof (DEVC(devc)->stats));
+}
+
+void
+eve_linux_sleep(intptr_t devc, uint32_t us)
+{
+	eve__sleep((struct eve *)devc, us);
+}
+
+#endif /* !EVE_LINUX */
@@ -0,0 +1,54 @@
+#ifndef EVE_LINUX_H
+#define EVE_LINUX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Simulated BT816 running on the host, memory and registers are emulated and
+ * every transaction is charged against a model of the SPI link so driver
+ * changes can be measured without hardware.
+ */
+
+struct eve_cfg {
+	/* SPI clock of the modelled link in Hz. */
+	int64_t spi_clk_speed;
+
+	/*
+	 * Fixed cost of each transaction in nanoseconds, CS toggling and the
+	 * host driver setup.
+	 */
+	int32_t latency_ns;
+
+	/* Maximum number of data lines (1, 2 or 4), see eve_set_width. */
+	int8_t spi_width;
+
+	/* Size of the attached flash in bytes, 0 if none. */
+	uint32_t flash_size;
+};
+
+struct eve_linux_stats {
+	uint64_t transactions;          /* host commands, reads and writes */
+	uint64_t bytes;                 /* on the wire, address included */
+	uint64_t time_ns;               /* modelled link time */
+	uint64_t swaps;                 /* display lists swapped */
+	uint64_t cp_words;              /* words consumed by the coprocessor */
+};
+
+/**
+ * Copy the counters since the device was initialized or last reset.
+ */
+int
+eve_linux_stats(intptr_t devc, struct eve_linux_stats *stats);
+
+void
+eve_linux_stats_reset(intptr_t devc);
+
+/**
+ * Let time pass on the device without any transaction, for the host side of
+ * a test sleeping.
+ */
+void
+eve_linux_sleep(intptr_t devc, uint32_t us);
+
+#endif /* !EVE_LINUX_H */
@@ -0,0 +1,232 @@
+#if defined(EVE_ESP32)
+
+#include <assert.h>
+#include <string.h>
+
+#include <esp_log.h>
+
+#include "eve.h"
+#include "eve_queue.h"
+
+#define TAG "eve"
+
+#define MASK            (EVE_QUEUE_SLOTS - 1)
+
+/* Event group bits. */
+#define PROGRESS        0x1
+#define STOPPED         0x2
+
+_Static_assert((EVE_QUEUE_SLOTS & MASK) == 0, "EVE_QUEUE_SLOTS must be a power of two");
+
+/*
+ * Move every published packet into the staging buffer and send them at once,
+ * returns 0 if there was nothing to do.
+ */
+static int
+queue_drain(struct eve_queue *queue)
+{
+	struct eve_queue_slot *slot;
+	uint32_t pos = queue->tail;
+	unsigned flags = 0;
+	int rc = 0;
+
+	/* At most a lap per batch so fences progress under constant load. */
+	while (pos - queue->tail < EVE_QUEUE_SLOTS) {
+		slot = &queue->slots[pos & MASK];
+
+		if ((int32_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - (pos + 1)) < 0)
+			break;
+
+		if (rc == 0 && eve_cp_push_data(&queue->cp, slot->buf, slot->len * 4) < 0)
+			rc = -1;
+
+		flags |= slot->flags;
+
+		/* Hand the slot back to the producers for the next lap. */
+		atomic_store_explicit(&slot->seq, pos + EVE_QUEUE_SLOTS, memory_order_release);
+		pos++;
+	}
+
+	if (pos == queue->tail)
+		return 0;
+
+	if (rc == 0)
+		rc = eve_cp_flush(&queue->cp);
+	if (rc == 0 && (flags & EVE_QUEUE_EXECUTED))
+		rc = eve_wait_cmdempty(queue->cp.devc, EVE_WAIT_FOREVER);
+
+	if (rc < 0) {
+		ESP_LOGW(TAG, "command queue batch up to %lu failed", (unsigned long)pos);
+		queue->cp.len = 0;
+		atomic_store_explicit(&queue->failed_start, queue->tail, memory_order_relaxed);
+		atomic_store_explicit(&queue->failed_end, pos, memory_order_relaxed);
+	}
+
+	queue->tail = pos;
+
+	atomic_store_explicit(&queue->done, pos, memory_order_release);
+
+	return 1;
+}
+
+static void
+queue_task(void *data)
+{
+	struct eve_queue *queue = data;
+
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		while (queue_drain(queue))
+			continue;
+
+		/* Wake up whoever waits right now, see eve_queue_wait. */
+		xEventGroupSetBits(queue->events, PROGRESS);
+		xEventGroupClearBits(queue->events, PROGRESS);
+
+		if (atomic_load(&queue->stop))
+			break;
+	}
+
+	xEventGroupSetBits(queue->events, STOPPED);
+	vTaskDelete(NULL);
+}
+
+int
+eve_queue_open(struct eve_queue *queue, intptr_t devc, int core, int prio)
+{
+	assert(queue);
+
+	BaseType_t rc;
+
+	memset(queue, 0, sizeof (*queue));
+	eve_cp_init(&queue->cp, devc);
+
+	for (uint32_t i = 0; i < EVE_QUEUE_SLOTS; ++i)
+		atomic_init(&queue->slots[i].seq, i);
+
+	if (!(queue->events = xEventGroupCreate())) {
+		ESP_LOGW(TAG, "unable to create command queue events");
+		return -1;
+	}
+
+	if (core < 0 || core >= portNUM_PROCESSORS)
+		core = tskNO_AFFINITY;
+
+	rc = xTaskCreatePinnedToCore(queue_task, "eve-queue", 4096, queue, prio, &queue->task, core);
+
+	if (rc != pdPASS) {
+		ESP_LOGW(TAG, "unable to create command queue task");
+		vEventGroupDelete(queue->events);
+		queue->events = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+int
+eve_queue_push(struct eve_queue *queue,
+               const uint32_t *words,
+               size_t n,
+               unsigned flags,
+               uint32_t *fence)
+{
+	assert(queue);
+	assert(words || n == 0);
+
+	struct eve_queue_slot *slot;
+	unsigned pos, seq;
+
+	/* Nothing would ever drain it, or notify a deleted task. */
+	if (n > EVE_QUEUE_PACKET_MAX || !queue->task || atomic_load(&queue->stop))
+		return -1;
+
+	pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+	for (;;) {
+		slot = &queue->slots[pos & MASK];
+		seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+		if ((int32_t)(seq - pos) == 0) {
+			if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+			                                          memory_order_relaxed,
+			                                          memory_order_relaxed))
+				break;
+		} else if ((int32_t)(seq - pos) < 0) {
+			/* Slot not drained since the previous lap, full. */
+			return -1;
+		} else {
+			/* Another producer got it first. */
+			pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+		}
+	}
+
+	memcpy(slot->buf, words, n * 4);
+	slot->len = n;
+	slot->flags = flags;
+
+	/* The release makes the packet visible before the slot is published. */
+	atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+	xTaskNotifyGive(queue->task);
+
+	if (fence)
+		*fence = pos + 1;
+
+	return 0;
+}
+
+/*
+ * The task only pulses PROGRESS, a waiter checking the fence right before
+ * the pulse and blocking right after would miss it, so it never blocks more
+ * than a tick before checking again.
+ */
+int
+eve_queue_wait(struct eve_queue *queue, uint32_t fence, uint32_t timeout_ms)
+{
+	assert(queue);
+
+	TickType_t now = xTaskGetTickCount(), ticks, elapsed;
+	uint32_t done, start, end;
+
+	ticks = timeout_ms == EVE_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+	for (;;) {
+		done = atomic_load_explicit(&queue->done, memory_order_acquire);
+
+		if ((int32_t)(done - fence) >= 0)
+			break;
+
+		elapsed = xTaskGetTickCount() - now;
+
+		if (ticks != portMAX_DELAY && elapsed >= ticks)
+			return -1;
+
+		xEventGroupWaitBits(queue->events, PROGRESS, pdFALSE, pdFALSE, 1);
+	}
+
+	/* Fences of a batch are start + 1 to end included. */
+	start = atomic_load_explicit(&queue->failed_start, memory_order_relaxed);
+	end = atomic_load_explicit(&queue->failed_end, memory_order_relaxed);
+
+	return fence - start - 1 < end - start ? -1 : 0;
+}
+
+void
+eve_queue_close(struct eve_queue *queue)
+{
+	assert(queue);
+
+	if (!queue->task)
+		return;
+
+	atomic_store(&queue->stop, 1);
+	xTaskNotifyGive(queue->task);
+	xEventGroupWaitBits(queue->events, STOPPED, pdFALSE, pdFALSE, portMAX_DELAY);
+
+	vEventGroupDelete(queue->events);
+	queue->task = NULL;
+	queue->events = NULL;
+}
+
+#endif /* !EVE_ESP32 */
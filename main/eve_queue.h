@@ -0,0 +1,115 @@
+#ifndef EVE_QUEUE_H
+#define EVE_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+
+#include "eve.h"
+
+/*
+ * Coprocessor command queue owned by a single transport task.
+ *
+ * Any task may push pre-encoded coprocessor packets without blocking, they
+ * land in a bounded lock-free ring (one sequence number per slot, producers
+ * claim a position with a compare and swap). The transport task is the only
+ * consumer, it drains every packet available into one eve_cp staging buffer
+ * and sends them in as few bursts as the FIFO allows.
+ *
+ * Each push returns a fence, the position of the packet in the queue, which
+ * can be waited on to know when the packet reached the device.
+ *
+ * While open the queue must be the only user of the command FIFO: every
+ * coprocessor command goes through eve_queue_push, none through eve_cp_*
+ * staging buffers of other tasks. Their sequences would otherwise end up
+ * between queued packets, and EVE_QUEUE_EXECUTED would also wait for their
+ * commands.
+ */
+
+/*
+ * Number of packets the queue holds, must be a power of two.
+ */
+#ifndef EVE_QUEUE_SLOTS
+#       define EVE_QUEUE_SLOTS          32
+#endif
+
+/*
+ * Maximum size of a packet in 32-bit words.
+ */
+#ifndef EVE_QUEUE_PACKET_MAX
+#       define EVE_QUEUE_PACKET_MAX     64
+#endif
+
+/* Let the transport task run on any core. */
+#define EVE_QUEUE_NO_AFFINITY           (-1)
+
+/*
+ * Flags for eve_queue_push: by default a fence is reached once the packet is
+ * in the command FIFO, with EVE_QUEUE_EXECUTED once the coprocessor has
+ * executed it.
+ */
+#define EVE_QUEUE_EXECUTED              0x1U
+
+struct eve_queue_slot {
+	atomic_uint seq;
+	uint16_t len;
+	uint16_t flags;
+	uint32_t buf[EVE_QUEUE_PACKET_MAX];
+};
+
+struct eve_queue {
+	struct eve_cp cp;
+	atomic_uint head;               /* next position claimed by producers */
+	uint32_t tail;                  /* next position drained, task only */
+	atomic_uint done;               /* packets completed */
+	atomic_uint failed_start;       /* last batch that failed */
+	atomic_uint failed_end;
+	atomic_int stop;
+	TaskHandle_t task;
+	EventGroupHandle_t events;
+	struct eve_queue_slot slots[EVE_QUEUE_SLOTS];
+};
+
+/**
+ * Start the transport task for devc.
+ *
+ * The task is pinned to core unless EVE_QUEUE_NO_AFFINITY, a core the system
+ * doesn't have (single core builds) also means no affinity.
+ */
+int
+eve_queue_open(struct eve_queue *queue, intptr_t devc, int core, int prio);
+
+/**
+ * Copy a packet of n words into the queue, from any task.
+ *
+ * Never blocks, returns -1 if the queue is full, the packet too large or
+ * the queue not open. The packet fence is stored in fence unless NULL.
+ */
+int
+eve_queue_push(struct eve_queue *queue,
+               const uint32_t *words,
+               size_t n,
+               unsigned flags,
+               uint32_t *fence);
+
+/**
+ * Wait until the packet with the given fence has completed.
+ *
+ * Returns 0 when done, -1 on timeout or if the batch holding the fence
+ * failed. Only the most recent failed batch is remembered.
+ */
+int
+eve_queue_wait(struct eve_queue *queue, uint32_t fence, uint32_t timeout_ms);
+
+/**
+ * Send everything queued and stop the task, pushes fail from then on. No
+ * push may be in progress meanwhile.
+ */
+void
+eve_queue_close(struct eve_queue *queue);
+
+#endif /* !EVE_QUEUE_H */
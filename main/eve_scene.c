@@ -0,0 +1,619 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_scene.h"
+
+/* Longest body, a full text. */
+#define BODY_MAX        (EVE_SCENE_TEXT_MAX + 8)
+
+/* VERTEX2II x field, glyphs are placed relative to the node. */
+#define VERTEX2II_MAX   511
+
+#define RGB(c)          ((c) & 0xffffff)
+#define ALPHA(c)        ((c) >> 24)
+
+/* State fields known while building the list. */
+#define KNOWN_RGB       0x01
+#define KNOWN_ALPHA     0x02
+#define KNOWN_TX        0x04
+#define KNOWN_TY        0x08
+#define KNOWN_WIDTH     0x10
+#define KNOWN_PRIM      0x20
+#define KNOWN_TAG       0x40
+#define KNOWN_MASK      0x80
+
+/* Words a list without merging would spend on each header, END included. */
+#define HEADER_WORDS    9
+
+static int
+state_eq(const struct eve_scene_state *a, const struct eve_scene_state *b)
+{
+	return a->color == b->color && a->tx == b->tx && a->ty == b->ty &&
+	       a->width == b->width && a->prim == b->prim && a->tag == b->tag &&
+	       a->mask == b->mask;
+}
+
+static struct eve_scene_node *
+node_get(struct eve_scene *scene, int id)
+{
+	assert(id >= 0 && id < EVE_SCENE_NODES);
+	assert(scene->nodes[id].type != EVE_SCENE_NONE);
+
+	return &scene->nodes[id];
+}
+
+static int
+node_add(struct eve_scene *scene, uint8_t type, uint8_t layer, int16_t x, int16_t y, uint16_t w, uint16_t h, uint32_t color)
+{
+	struct eve_scene_node *node;
+
+	for (int id = 0; id < EVE_SCENE_NODES; ++id) {
+		node = &scene->nodes[id];
+
+		if (node->type != EVE_SCENE_NONE)
+			continue;
+
+		memset(node, 0, sizeof (*node));
+		node->type = type;
+		node->layer = layer;
+		node->x = x;
+		node->y = y;
+		node->w = w;
+		node->h = h;
+		node->color = color;
+		node->dirty = 1;
+		node->seq = scene->seq++;
+
+		scene->order[scene->count++] = id;
+		scene->rebuild = 1;
+		scene->sort = 1;
+
+		return id;
+	}
+
+	return -1;
+}
+
+static void
+rect(uint32_t *body, size_t *len, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+	body[(*len)++] = EVE__DL_VERTEX2F(x0 * 16, y0 * 16);
+	body[(*len)++] = EVE__DL_VERTEX2F(x1 * 16, y1 * 16);
+}
+
+/*
+ * Encode the body of node and the state it needs first and leaves behind.
+ */
+static size_t
+node_encode(struct eve_scene_node *node, uint32_t *body)
+{
+	struct eve_scene_state *st = &node->enter;
+	uint16_t r, fill;
+	size_t len = 0;
+
+	memset(st, 0, sizeof (*st));
+	st->color = node->color;
+	st->tag = node->tag;
+	st->mask = 0xf;
+
+	switch (node->type) {
+	case EVE_SCENE_RECT:
+	case EVE_SCENE_REGION:
+		/* Rounded corners are circles of LINE_WIDTH radius around the vertices. */
+		r = node->type == EVE_SCENE_RECT ? node->u.radius : 0;
+		st->prim = EVE_PRIM_RECTS;
+		st->width = r ? r * 16 : 16;
+		st->mask = node->type == EVE_SCENE_RECT ? 0xf : 0;
+		rect(body, &len, node->x + r, node->y + r, node->x + node->w - r, node->y + node->h - r);
+		break;
+	case EVE_SCENE_TEXT:
+		st->prim = EVE_PRIM_BITMAPS;
+		st->tx = node->x;
+		st->ty = node->y;
+
+		for (size_t i = 0; node->u.text.str[i]; ++i)
+			body[len++] = EVE__DL_VERTEX2II(i * node->u.text.advance, 0, node->u.text.font, node->u.text.str[i]);
+		break;
+	case EVE_SCENE_BITMAP:
+		st->prim = EVE_PRIM_BITMAPS;
+		st->tx = node->x;
+		st->ty = node->y;
+		body[len++] = EVE__DL_VERTEX2II(0, 0, node->u.bitmap.handle, node->u.bitmap.cell);
+		break;
+	case EVE_SCENE_GAUGE:
+		/* Same length whatever the value, updates are patched. */
+		fill = node->u.gauge.range ? (uint32_t)node->w * node->u.gauge.value / node->u.gauge.range : 0;
+		st->prim = EVE_PRIM_RECTS;
+		st->width = 16;
+		rect(body, &len, node->x, node->y, node->x + node->w, node->y + node->h);
+		body[len++] = EVE__DL_COLOR_RGB(node->u.gauge.fill >> 16 & 0xff,
+		                                node->u.gauge.fill >> 8 & 0xff,
+		                                node->u.gauge.fill & 0xff);
+		body[len++] = EVE__DL_COLOR_A(ALPHA(node->u.gauge.fill));
+		rect(body, &len, node->x, node->y, node->x + fill, node->y + node->h);
+		break;
+	}
+
+	node->leave = *st;
+
+	if (node->type == EVE_SCENE_GAUGE)
+		node->leave.color = node->u.gauge.fill;
+
+	return len;
+}
+
+/*
+ * Move every body to the start of the pool, in pool order so that none is
+ * overwritten before being moved.
+ */
+static void
+pool_compact(struct eve_scene *scene)
+{
+	struct eve_scene_node *node, *next;
+	uint16_t from = 0;
+
+	scene->pool_len = 0;
+
+	for (;;) {
+		next = NULL;
+
+		for (size_t i = 0; i < EVE_SCENE_NODES; ++i) {
+			node = &scene->nodes[i];
+
+			if (node->type != EVE_SCENE_NONE && node->cap && node->span >= from &&
+			    (!next || node->span < next->span))
+				next = node;
+		}
+
+		if (!next)
+			break;
+
+		from = next->span + 1;
+		memmove(&scene->pool[scene->pool_len], &scene->pool[next->span], next->len * 4);
+		next->span = scene->pool_len;
+		scene->pool_len += next->cap;
+	}
+
+	scene->stats.compactions++;
+}
+
+static int
+pool_store(struct eve_scene *scene, struct eve_scene_node *node, const uint32_t *body, size_t len)
+{
+	/* Text reserves room for its longest string, no reallocation on update. */
+	size_t cap = node->type == EVE_SCENE_TEXT ? EVE_SCENE_TEXT_MAX - 1 : len;
+
+	if (len > node->cap) {
+		if (scene->pool_len + cap > EVE_SCENE_POOL) {
+			node->cap = 0;
+			pool_compact(scene);
+		}
+		if (scene->pool_len + cap > EVE_SCENE_POOL)
+			return -1;
+
+		node->span = scene->pool_len;
+		node->cap = cap;
+		scene->pool_len += cap;
+	}
+
+	memcpy(&scene->pool[node->span], body, len * 4);
+	node->len = len;
+
+	return 0;
+}
+
+/*
+ * Bring the body of a changed node up to date, in the list too when it kept
+ * its place.
+ */
+static int
+node_update(struct eve_scene *scene, struct eve_scene_node *node)
+{
+	struct eve_scene_state enter = node->enter, leave = node->leave;
+	uint32_t body[BODY_MAX];
+	size_t len;
+
+	len = node_encode(node, body);
+	scene->stats.encoded++;
+
+	if (!scene->rebuild && node->placed && len == node->len &&
+	    state_eq(&enter, &node->enter) && state_eq(&leave, &node->leave)) {
+		memcpy(&scene->pool[node->span], body, len * 4);
+		memcpy(&scene->list[node->at], body, len * 4);
+		scene->stats.patched++;
+	} else {
+		scene->rebuild = 1;
+
+		/* Sorted by colour. */
+		if (enter.color != node->enter.color || enter.prim != node->enter.prim)
+			scene->sort = 1;
+
+		if (pool_store(scene, node, body, len) < 0)
+			return -1;
+	}
+
+	node->dirty = 0;
+
+	return 0;
+}
+
+static int
+node_before(const struct eve_scene_node *a, const struct eve_scene_node *b)
+{
+	if (a->layer != b->layer)
+		return a->layer < b->layer;
+	if (a->enter.prim != b->enter.prim)
+		return a->enter.prim < b->enter.prim;
+	if (a->enter.color != b->enter.color)
+		return a->enter.color < b->enter.color;
+
+	return a->seq < b->seq;
+}
+
+/*
+ * Insertion sort, the order is mostly sorted already.
+ */
+static void
+order_sort(struct eve_scene *scene)
+{
+	uint16_t id;
+	size_t j;
+
+	for (size_t i = 1; i < scene->count; ++i) {
+		id = scene->order[i];
+
+		for (j = i; j > 0 && node_before(&scene->nodes[id], &scene->nodes[scene->order[j - 1]]); --j)
+			scene->order[j] = scene->order[j - 1];
+
+		scene->order[j] = id;
+	}
+
+	scene->sort = 0;
+}
+
+/*
+ * Emit the words changing cur into want, returns the number of words or -1
+ * if the list is full.
+ */
+static int
+header_emit(struct eve_scene *scene, struct eve_scene_state *cur, uint8_t *known, const struct eve_scene_state *want)
+{
+	uint32_t words[HEADER_WORDS];
+	size_t n = 0;
+
+	if (!(*known & KNOWN_RGB) || RGB(cur->color) != RGB(want->color))
+		words[n++] = EVE__DL_COLOR_RGB(want->color >> 16 & 0xff, want->color >> 8 & 0xff, want->color & 0xff);
+	if (!(*known & KNOWN_ALPHA) || ALPHA(cur->color) != ALPHA(want->color))
+		words[n++] = EVE__DL_COLOR_A(ALPHA(want->color));
+	if (!(*known & KNOWN_TX) || cur->tx != want->tx)
+		words[n++] = EVE__DL_VERTEX_TRANSLATE_X(want->tx * 16);
+	if (!(*known & KNOWN_TY) || cur->ty != want->ty)
+		words[n++] = EVE__DL_VERTEX_TRANSLATE_Y(want->ty * 16);
+	if (want->width && (!(*known & KNOWN_WIDTH) || cur->width != want->width))
+		words[n++] = EVE__DL_LINE_WIDTH(want->width);
+	if (!(*known & KNOWN_PRIM) || cur->prim != want->prim)
+		words[n++] = EVE__DL_BEGIN(want->prim);
+	if (!(*known & KNOWN_TAG) || cur->tag != want->tag)
+		words[n++] = EVE__DL_TAG(want->tag);
+	if (!(*known & KNOWN_MASK) || cur->mask != want->mask)
+		words[n++] = EVE__DL_COLOR_MASK(want->mask >> 3 & 1, want->mask >> 2 & 1, want->mask >> 1 & 1, want->mask & 1);
+
+	if (n > EVE_DL_MAX - scene->list_len)
+		return -1;
+
+	memcpy(&scene->list[scene->list_len], words, n * 4);
+	scene->list_len += n;
+
+	*known |= KNOWN_RGB | KNOWN_ALPHA | KNOWN_TX | KNOWN_TY | KNOWN_PRIM | KNOWN_TAG | KNOWN_MASK;
+
+	if (want->width)
+		*known |= KNOWN_WIDTH;
+
+	return n;
+}
+
+static int
+list_build(struct eve_scene *scene)
+{
+	struct eve_scene_state cur = { 0 };
+	struct eve_scene_node *node;
+	uint16_t width;
+	uint8_t known = 0;
+	int n;
+
+	if (scene->sort)
+		order_sort(scene);
+
+	scene->list_len = 0;
+	scene->stats.rebuilds++;
+
+	for (size_t i = 0; i < EVE_SCENE_NODES; ++i)
+		scene->nodes[i].placed = 0;
+
+	for (size_t i = 0; i < scene->count; ++i) {
+		node = &scene->nodes[scene->order[i]];
+
+		if (node->hidden)
+			continue;
+
+		if ((n = header_emit(scene, &cur, &known, &node->enter)) < 0 ||
+		    node->len > EVE_DL_MAX - scene->list_len)
+			return -1;
+
+		scene->stats.merged += HEADER_WORDS - n;
+
+		memcpy(&scene->list[scene->list_len], &scene->pool[node->span], node->len * 4);
+		node->at = scene->list_len;
+		node->placed = 1;
+		scene->list_len += node->len;
+
+		/* Nodes not drawing lines or rects leave LINE_WIDTH alone. */
+		width = cur.width;
+		cur = node->leave;
+
+		if (!cur.width)
+			cur.width = width;
+	}
+
+	scene->rebuild = 0;
+
+	return 0;
+}
+
+void
+eve_scene_init(struct eve_scene *scene)
+{
+	assert(scene);
+
+	memset(scene, 0, offsetof(struct eve_scene, pool));
+}
+
+int
+eve_scene_rect(struct eve_scene *scene,
+               uint8_t layer,
+               int16_t x,
+               int16_t y,
+               uint16_t w,
+               uint16_t h,
+               uint32_t color,
+               uint16_t radius)
+{
+	assert(scene);
+
+	int id = node_add(scene, EVE_SCENE_RECT, layer, x, y, w, h, color);
+
+	if (id >= 0)
+		scene->nodes[id].u.radius = radius;
+
+	return id;
+}
+
+int
+eve_scene_text(struct eve_scene *scene,
+               uint8_t layer,
+               int16_t x,
+               int16_t y,
+               uint8_t font,
+               uint8_t advance,
+               uint32_t color,
+               const char *str)
+{
+	assert(scene);
+	assert(str);
+
+	int id;
+
+	/* The last glyph of the longest text must not wrap to the left. */
+	if (advance * (EVE_SCENE_TEXT_MAX - 1) > VERTEX2II_MAX)
+		return -1;
+
+	id = node_add(scene, EVE_SCENE_TEXT, layer, x, y, 0, 0, color);
+
+	if (id >= 0) {
+		scene->nodes[id].u.text.font = font;
+		scene->nodes[id].u.text.advance = advance;
+		strncpy(scene->nodes[id].u.text.str, str, EVE_SCENE_TEXT_MAX - 1);
+	}
+
+	return id;
+}
+
+int
+eve_scene_bitmap(struct eve_scene *scene,
+                 uint8_t layer,
+                 int16_t x,
+                 int16_t y,
+                 uint8_t handle,
+                 uint8_t cell,
+                 uint32_t color)
+{
+	assert(scene);
+
+	int id = node_add(scene, EVE_SCENE_BITMAP, layer, x, y, 0, 0, color);
+
+	if (id >= 0) {
+		scene->nodes[id].u.bitmap.handle = handle;
+		scene->nodes[id].u.bitmap.cell = cell;
+	}
+
+	return id;
+}
+
+int
+eve_scene_gauge(struct eve_scene *scene,
+                uint8_t layer,
+                int16_t x,
+                int16_t y,
+                uint16_t w,
+                uint16_t h,
+                uint32_t back,
+                uint32_t fill,
+                uint16_t range)
+{
+	assert(scene);
+
+	int id = node_add(scene, EVE_SCENE_GAUGE, layer, x, y, w, h, back);
+
+	if (id >= 0) {
+		scene->nodes[id].u.gauge.fill = fill;
+		scene->nodes[id].u.gauge.range = range;
+	}
+
+	return id;
+}
+
+int
+eve_scene_region(struct eve_scene *scene,
+                 uint8_t layer,
+                 int16_t x,
+                 int16_t y,
+                 uint16_t w,
+                 uint16_t h,
+                 uint8_t tag)
+{
+	assert(scene);
+
+	int id = node_add(scene, EVE_SCENE_REGION, layer, x, y, w, h, 0xffffffff);
+
+	if (id >= 0)
+		scene->nodes[id].tag = tag;
+
+	return id;
+}
+
+void
+eve_scene_remove(struct eve_scene *scene, int id)
+{
+	assert(scene);
+
+	size_t i;
+
+	node_get(scene, id)->type = EVE_SCENE_NONE;
+
+	for (i = 0; scene->order[i] != id; ++i)
+		;
+
+	memmove(&scene->order[i], &scene->order[i + 1], (scene->count - i - 1) * sizeof (scene->order[0]));
+	scene->count--;
+	scene->rebuild = 1;
+}
+
+void
+eve_scene_move(struct eve_scene *scene, int id, int16_t x, int16_t y)
+{
+	assert(scene);
+
+	struct eve_scene_node *node = node_get(scene, id);
+
+	if (node->x == x && node->y == y)
+		return;
+
+	node->x = x;
+	node->y = y;
+	node->dirty = 1;
+}
+
+void
+eve_scene_color(struct eve_scene *scene, int id, uint32_t color)
+{
+	assert(scene);
+
+	struct eve_scene_node *node = node_get(scene, id);
+
+	if (node->color == color)
+		return;
+
+	node->color = color;
+	node->dirty = 1;
+}
+
+void
+eve_scene_tag(struct eve_scene *scene, int id, uint8_t tag)
+{
+	assert(scene);
+
+	struct eve_scene_node *node = node_get(scene, id);
+
+	if (node->tag == tag)
+		return;
+
+	node->tag = tag;
+	node->dirty = 1;
+}
+
+void
+eve_scene_hide(struct eve_scene *scene, int id, int hidden)
+{
+	assert(scene);
+
+	struct eve_scene_node *node = node_get(scene, id);
+
+	if (node->hidden == !!hidden)
+		return;
+
+	node->hidden = !!hidden;
+	scene->rebuild = 1;
+}
+
+void
+eve_scene_set_text(struct eve_scene *scene, int id, const char *str)
+{
+	assert(scene);
+	assert(str);
+
+	struct eve_scene_node *node = node_get(scene, id);
+
+	assert(node->type == EVE_SCENE_TEXT);
+
+	if (strncmp(node->u.text.str, str, EVE_SCENE_TEXT_MAX - 1) == 0)
+		return;
+
+	strncpy(node->u.text.str, str, EVE_SCENE_TEXT_MAX - 1);
+	node->dirty = 1;
+}
+
+void
+eve_scene_set_value(struct eve_scene *scene, int id, uint16_t value)
+{
+	assert(scene);
+
+	struct eve_scene_node *node = node_get(scene, id);
+
+	assert(node->type == EVE_SCENE_GAUGE);
+
+	if (value > node->u.gauge.range)
+		value = node->u.gauge.range;
+	if (node->u.gauge.value == value)
+		return;
+
+	node->u.gauge.value = value;
+	node->dirty = 1;
+}
+
+int
+eve_scene_render(struct eve_scene *scene, struct eve_dl *dl)
+{
+	assert(scene);
+	assert(dl);
+
+	struct eve_scene_node *node;
+	int rc = 0;
+
+	for (size_t i = 0; i < scene->count; ++i) {
+		node = &scene->nodes[scene->order[i]];
+
+		if (node->dirty && node_update(scene, node) < 0)
+			rc = -1;
+	}
+
+	if (scene->rebuild && list_build(scene) < 0)
+		rc = -1;
+
+	scene->failed = rc < 0;
+
+	if (eve_dl_append(dl, scene->list, scene->list_len) < 0)
+		return -1;
+
+	return rc;
+}
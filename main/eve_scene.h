@@ -0,0 +1,249 @@
+#ifndef EVE_SCENE_H
+#define EVE_SCENE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "eve.h"
+
+/*
+ * Retained scene of widgets compiled into a display list.
+ *
+ * Each node caches the words it draws with (its body) and the graphics
+ * state it needs first (its header). Only nodes changed since the last
+ * frame are encoded again:
+ *
+ * - a new body of the same length with the same header and exit state is
+ *   patched into the previous list in place, the common case of a value,
+ *   colour change within a gauge or same length text update;
+ *
+ * - anything else (node added, removed, hidden, moved to another state)
+ *   rebuilds the list from the cached bodies.
+ *
+ * On rebuild headers are merged: COLOR_RGB, COLOR_A, BEGIN, LINE_WIDTH, TAG,
+ * COLOR_MASK and VERTEX_TRANSLATE are only emitted when they differ from the
+ * state left by the previous node and END is never emitted. Glyphs and
+ * bitmaps use VERTEX2II which carries the handle, BITMAP_HANDLE is never
+ * needed. Nodes are drawn by layer, within a layer they are sorted by
+ * primitive and colour so that similar nodes share their state.
+ *
+ * The list leaves the graphics state as its last node set it.
+ *
+ * Frames go to RAM_DL without the coprocessor so gauges are bar gauges and
+ * text is drawn glyph by glyph with VERTEX2II from a ROM or loaded font
+ * (handles 0 to 31) with a fixed advance, at most 511 pixels wide.
+ */
+
+/*
+ * Maximum number of nodes.
+ */
+#ifndef EVE_SCENE_NODES
+#       define EVE_SCENE_NODES          256
+#endif
+
+/*
+ * Words of cached bodies.
+ */
+#ifndef EVE_SCENE_POOL
+#       define EVE_SCENE_POOL           4096
+#endif
+
+/*
+ * Longest text, NUL included.
+ */
+#ifndef EVE_SCENE_TEXT_MAX
+#       define EVE_SCENE_TEXT_MAX       32
+#endif
+
+enum eve_scene_type {
+	EVE_SCENE_NONE,                 /* free slot */
+	EVE_SCENE_RECT,
+	EVE_SCENE_TEXT,
+	EVE_SCENE_BITMAP,
+	EVE_SCENE_GAUGE,
+	EVE_SCENE_REGION,               /* invisible, only sets a tag */
+};
+
+/*
+ * Graphics state a body relies on.
+ */
+struct eve_scene_state {
+	uint32_t color;                 /* ARGB */
+	int16_t tx, ty;                 /* VERTEX_TRANSLATE, pixels */
+	uint16_t width;                 /* LINE_WIDTH, 1/16 pixel, 0 if unused */
+	uint8_t prim;                   /* EVE_PRIM_* */
+	uint8_t tag;
+	uint8_t mask;                   /* COLOR_MASK, r g b a from bit 3 to 0 */
+};
+
+struct eve_scene_node {
+	uint8_t type;                   /* EVE_SCENE_* */
+	uint8_t layer;
+	uint8_t tag;
+	uint8_t hidden;
+	uint8_t dirty;
+	uint32_t color;                 /* ARGB, gauge background */
+	int16_t x, y;
+	uint16_t w, h;
+
+	union {
+		uint16_t radius;        /* rect */
+		struct {
+			uint8_t font;
+			uint8_t advance;
+			char str[EVE_SCENE_TEXT_MAX];
+		} text;
+		struct {
+			uint8_t handle;
+			uint8_t cell;
+		} bitmap;
+		struct {
+			uint32_t fill;  /* ARGB */
+			uint16_t value;
+			uint16_t range;
+		} gauge;
+	} u;
+
+	/* Cache. */
+	struct eve_scene_state enter;
+	struct eve_scene_state leave;
+	uint16_t span;                  /* body in the pool */
+	uint16_t len;
+	uint16_t cap;
+	uint16_t at;                    /* body in the list */
+	uint8_t placed;                 /* at is valid */
+	uint32_t seq;                   /* insertion order */
+};
+
+struct eve_scene_stats {
+	uint32_t encoded;               /* bodies encoded */
+	uint32_t patched;               /* bodies patched in the list */
+	uint32_t rebuilds;              /* lists rebuilt */
+	uint32_t merged;                /* state words saved by rebuilds */
+	uint32_t compactions;           /* pool compactions */
+};
+
+struct eve_scene {
+	int rebuild;                    /* list must be rebuilt */
+	int sort;                       /* order must be sorted */
+	int failed;                     /* last rebuild overflowed */
+	uint32_t seq;
+	size_t pool_len;
+	size_t list_len;
+	size_t count;                   /* nodes in order */
+	struct eve_scene_stats stats;
+	uint16_t order[EVE_SCENE_NODES];
+	struct eve_scene_node nodes[EVE_SCENE_NODES];
+	uint32_t pool[EVE_SCENE_POOL];
+	uint32_t list[EVE_DL_MAX];
+};
+
+/**
+ * Start with an empty scene.
+ */
+void
+eve_scene_init(struct eve_scene *scene);
+
+/**
+ * Add a rectangle with corners rounded by radius pixels.
+ *
+ * Like the other constructors returns the node id or -1 if the scene is
+ * full.
+ */
+int
+eve_scene_rect(struct eve_scene *scene,
+               uint8_t layer,
+               int16_t x,
+               int16_t y,
+               uint16_t w,
+               uint16_t h,
+               uint32_t color,
+               uint16_t radius);
+
+/**
+ * Add str drawn with font, each glyph advance pixels after the previous one.
+ *
+ * Glyphs are placed with VERTEX2II relative to x: advance is limited to
+ * 511 / (EVE_SCENE_TEXT_MAX - 1) pixels (16 by default), -1 is returned
+ * above. Proportional or wider text goes through eve_font_run.
+ */
+int
+eve_scene_text(struct eve_scene *scene,
+               uint8_t layer,
+               int16_t x,
+               int16_t y,
+               uint8_t font,
+               uint8_t advance,
+               uint32_t color,
+               const char *str);
+
+/**
+ * Add cell of the bitmap set up on handle.
+ */
+int
+eve_scene_bitmap(struct eve_scene *scene,
+                 uint8_t layer,
+                 int16_t x,
+                 int16_t y,
+                 uint8_t handle,
+                 uint8_t cell,
+                 uint32_t color);
+
+/**
+ * Add a horizontal bar gauge filled by value / range.
+ */
+int
+eve_scene_gauge(struct eve_scene *scene,
+                uint8_t layer,
+                int16_t x,
+                int16_t y,
+                uint16_t w,
+                uint16_t h,
+                uint32_t back,
+                uint32_t fill,
+                uint16_t range);
+
+/**
+ * Add an invisible area reporting tag when touched.
+ */
+int
+eve_scene_region(struct eve_scene *scene,
+                 uint8_t layer,
+                 int16_t x,
+                 int16_t y,
+                 uint16_t w,
+                 uint16_t h,
+                 uint8_t tag);
+
+void
+eve_scene_remove(struct eve_scene *scene, int id);
+
+/*
+ * Node updates, changes are picked up by the next eve_scene_render. Setting
+ * the current value costs nothing.
+ */
+void
+eve_scene_move(struct eve_scene *scene, int id, int16_t x, int16_t y);
+
+void
+eve_scene_color(struct eve_scene *scene, int id, uint32_t color);
+
+void
+eve_scene_tag(struct eve_scene *scene, int id, uint8_t tag);
+
+void
+eve_scene_hide(struct eve_scene *scene, int id, int hidden);
+
+void
+eve_scene_set_text(struct eve_scene *scene, int id, const char *str);
+
+void
+eve_scene_set_value(struct eve_scene *scene, int id, uint16_t value);
+
+/**
+ * Bring the list up to date and append it to dl.
+ */
+int
+eve_scene_render(struct eve_scene *scene, struct eve_dl *dl);
+
+#endif /* !EVE_SCENE_H */
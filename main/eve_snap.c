@@ -0,0 +1,205 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_snap.h"
+
+struct compare {
+	struct eve_snap *snap;
+	eve_snap_golden_t golden;
+	void *arg;
+	struct eve_snap_diff *diff;
+};
+
+/* Nibble at a time, reflected 0xedb88320 polynomial. */
+static const uint32_t crc_table[16] = {
+	0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+	0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+	0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+	0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+uint32_t
+eve_snap_crc32(uint32_t crc, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+
+	crc = ~crc;
+
+	while (size--) {
+		crc ^= *p++;
+		crc = (crc >> 4) ^ crc_table[crc & 0xf];
+		crc = (crc >> 4) ^ crc_table[crc & 0xf];
+	}
+
+	return ~crc;
+}
+
+/*
+ * Render rows of the region starting at row into the staging area.
+ */
+static int
+snap_band(struct eve_snap *snap, uint16_t row, uint16_t rows)
+{
+	/* ARGB8 pixels count as two of the 16-bit ones the command expects. */
+	uint16_t w = snap->format == EVE_FORMAT_ARGB8_SNAPSHOT ? snap->width * 2 : snap->width;
+	int16_t y = snap->y + row;
+
+	if (eve_cp_push(snap->cp, EVE_CPC_SNAPSHOT2) < 0 ||
+	    eve_cp_push(snap->cp, snap->format) < 0 ||
+	    eve_cp_push(snap->cp, snap->staging) < 0 ||
+	    eve_cp_push(snap->cp, ((uint32_t)(uint16_t)y << 16) | (uint16_t)snap->x) < 0 ||
+	    eve_cp_push(snap->cp, ((uint32_t)rows << 16) | w) < 0)
+		return -1;
+
+	return eve_cp_wait(snap->cp);
+}
+
+int
+eve_snap_init(struct eve_snap *snap,
+              struct eve_cp *cp,
+              uint32_t staging,
+              uint32_t staging_size,
+              uint32_t format,
+              int16_t x,
+              int16_t y,
+              uint16_t width,
+              uint16_t height)
+{
+	assert(snap);
+	assert(cp);
+
+	switch (format) {
+	case EVE_FORMAT_RGB565:
+	case EVE_FORMAT_ARGB4:
+		snap->bpp = 2;
+		break;
+	case EVE_FORMAT_ARGB8_SNAPSHOT:
+		snap->bpp = 4;
+		break;
+	default:
+		return -1;
+	}
+
+	if (!width || !height || staging % 4 || staging_size < (uint32_t)width * snap->bpp)
+		return -1;
+
+	snap->cp = cp;
+	snap->staging = staging;
+	snap->staging_size = staging_size;
+	snap->format = format;
+	snap->x = x;
+	snap->y = y;
+	snap->width = width;
+	snap->height = height;
+	snap->crc = 0;
+	snap->bytes = 0;
+
+	return 0;
+}
+
+int
+eve_snap_capture(struct eve_snap *snap, eve_snap_sink_t sink, void *arg)
+{
+	assert(snap);
+
+	uint32_t pitch = (uint32_t)snap->width * snap->bpp;
+	uint32_t band = snap->staging_size / pitch;
+	uint32_t size, rows, n;
+
+	snap->crc = 0;
+	snap->bytes = 0;
+
+	for (uint32_t row = 0; row < snap->height; row += rows) {
+		rows = snap->height - row < band ? snap->height - row : band;
+		size = rows * pitch;
+
+		if (snap_band(snap, row, rows) < 0)
+			return -1;
+
+		for (uint32_t off = 0; off < size; off += n) {
+			n = size - off < EVE_SNAP_CHUNK ? size - off : EVE_SNAP_CHUNK;
+
+			if (eve_read(snap->cp->devc, snap->staging + off, snap->buf, n) < 0)
+				return -1;
+
+			snap->crc = eve_snap_crc32(snap->crc, snap->buf, n);
+
+			if (sink && sink(arg, snap->bytes, snap->buf, n) < 0)
+				return -1;
+
+			snap->bytes += n;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Chunks hold whole pixels: rows, bands and EVE_SNAP_CHUNK are multiples of
+ * the pixel size.
+ */
+static int
+compare_sink(void *arg, uint32_t offset, const void *data, size_t size)
+{
+	struct compare *cmp = arg;
+	struct eve_snap *snap = cmp->snap;
+	struct eve_snap_diff *diff = cmp->diff;
+	const uint8_t *a = data, *b = snap->golden;
+	uint32_t pixel;
+	uint16_t x, y;
+
+	if (cmp->golden(cmp->arg, offset, snap->golden, size) < 0)
+		return -1;
+
+	diff->golden_crc = eve_snap_crc32(diff->golden_crc, snap->golden, size);
+
+	if (memcmp(a, b, size) == 0)
+		return 0;
+
+	for (size_t i = 0; i < size; i += snap->bpp) {
+		if (memcmp(&a[i], &b[i], snap->bpp) == 0)
+			continue;
+
+		pixel = (offset + i) / snap->bpp;
+		x = pixel % snap->width;
+		y = pixel / snap->width;
+
+		if (!diff->pixels++) {
+			diff->x0 = diff->x1 = x;
+			diff->y0 = diff->y1 = y;
+			continue;
+		}
+
+		diff->x0 = x < diff->x0 ? x : diff->x0;
+		diff->x1 = x > diff->x1 ? x : diff->x1;
+		diff->y1 = y;
+	}
+
+	return 0;
+}
+
+int
+eve_snap_compare(struct eve_snap *snap,
+                 eve_snap_golden_t golden,
+                 void *arg,
+                 struct eve_snap_diff *diff)
+{
+	assert(snap);
+	assert(golden);
+	assert(diff);
+
+	struct compare cmp = {
+		.snap   = snap,
+		.golden = golden,
+		.arg    = arg,
+		.diff   = diff,
+	};
+
+	memset(diff, 0, sizeof (*diff));
+
+	if (eve_snap_capture(snap, compare_sink, &cmp) < 0)
+		return -1;
+
+	return diff->pixels ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+#ifndef EVE_SNAP_H
+#define EVE_SNAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Screen capture for golden image regression tests.
+ *
+ * CMD_SNAPSHOT2 renders the current display list into RAM_G, a screen does
+ * not fit there in ARGB8 so the region is captured in bands of as many rows
+ * as the staging area holds. Each band is read back with bursts of
+ * EVE_SNAP_CHUNK bytes and handed to a sink, the CRC-32 of the whole capture
+ * is computed on the way.
+ *
+ * In comparison mode each chunk is checked against the same bytes of a
+ * golden image, from a reader callback so the golden image doesn't have to
+ * fit in host memory, and the bounding box of the differing pixels is
+ * reported.
+ *
+ * The legacy REG_SNAPSHOT path, one line at a time through REG_SNAPY, is not
+ * used: CMD_SNAPSHOT2 does a band per command.
+ */
+
+struct eve_cp;
+
+/*
+ * Bytes per burst read.
+ */
+#ifndef EVE_SNAP_CHUNK
+#       define EVE_SNAP_CHUNK           2048
+#endif
+
+/**
+ * Consume size bytes of the capture starting at byte offset, rows are
+ * width * bytes per pixel long.
+ */
+typedef int (*eve_snap_sink_t)(void *arg, uint32_t offset, const void *data, size_t size);
+
+/**
+ * Read size bytes of the golden image at byte offset into buf.
+ */
+typedef int (*eve_snap_golden_t)(void *arg, uint32_t offset, void *buf, size_t size);
+
+struct eve_snap_diff {
+	uint32_t pixels;                /* differing, 0 if identical */
+	uint16_t x0, y0;                /* bounding box, inclusive, relative */
+	uint16_t x1, y1;                /* to the region, valid if pixels */
+	uint32_t golden_crc;
+};
+
+struct eve_snap {
+	struct eve_cp *cp;
+	uint32_t staging;               /* RAM_G */
+	uint32_t staging_size;
+	uint32_t format;                /* EVE_FORMAT_* */
+	uint8_t bpp;                    /* bytes per pixel */
+	int16_t x, y;
+	uint16_t width, height;
+	uint32_t crc;                   /* of the last capture */
+	uint32_t bytes;
+	uint8_t buf[EVE_SNAP_CHUNK];
+	uint8_t golden[EVE_SNAP_CHUNK];
+};
+
+/**
+ * Capture width x height pixels at x, y in format, one of RGB565, ARGB4 and
+ * ARGB8_SNAPSHOT, through staging_size bytes of RAM_G at staging.
+ *
+ * Returns -1 if the format is not supported or a row doesn't fit in the
+ * staging area.
+ */
+int
+eve_snap_init(struct eve_snap *snap,
+              struct eve_cp *cp,
+              uint32_t staging,
+              uint32_t staging_size,
+              uint32_t format,
+              int16_t x,
+              int16_t y,
+              uint16_t width,
+              uint16_t height);
+
+/**
+ * Capture the region, sink may be NULL when only the CRC is wanted.
+ */
+int
+eve_snap_capture(struct eve_snap *snap, eve_snap_sink_t sink, void *arg);
+
+/**
+ * Capture the region and compare it with the golden image.
+ *
+ * Returns 0 if both are identical, 1 if they differ and -1 on error.
+ */
+int
+eve_snap_compare(struct eve_snap *snap,
+                 eve_snap_golden_t golden,
+                 void *arg,
+                 struct eve_snap_diff *diff);
+
+/**
+ * Update a CRC-32 (IEEE 802.3) with size bytes, start from 0.
+ */
+uint32_t
+eve_snap_crc32(uint32_t crc, const void *data, size_t size);
+
+#endif /* !EVE_SNAP_H */
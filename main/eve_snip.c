@@ -0,0 +1,173 @@
+#include <assert.h>
+#include <string.h>
+
+#include "eve.h"
+#include "eve_gmem.h"
+#include "eve_snip.h"
+
+#define FNV_OFFSET      0xcbf29ce484222325ULL
+#define FNV_PRIME       0x100000001b3ULL
+
+static uint64_t
+snip_hash(const uint32_t *words, size_t n)
+{
+	const uint8_t *p = (const uint8_t *)words;
+	uint64_t hash = FNV_OFFSET;
+
+	for (size_t i = 0; i < n * 4; ++i) {
+		hash ^= p[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static int
+snip_find(const struct eve_snip *sc, uint64_t hash, uint32_t size)
+{
+	for (int i = 0; i < EVE_SNIP_MAX; ++i)
+		if (sc->entries[i].mem >= 0 && sc->entries[i].hash == hash && sc->entries[i].size == size)
+			return i;
+
+	return -1;
+}
+
+/*
+ * Least recently used fragment not in skip (may be NULL), -1 if there is
+ * none.
+ */
+static int
+snip_lru(const struct eve_snip *sc, const uint8_t *skip)
+{
+	int lru = -1;
+
+	for (int i = 0; i < EVE_SNIP_MAX; ++i) {
+		if (sc->entries[i].mem < 0 || (skip && skip[i]))
+			continue;
+		if (lru < 0 || sc->clock - sc->entries[i].stamp > sc->clock - sc->entries[lru].stamp)
+			lru = i;
+	}
+
+	return lru;
+}
+
+static void
+snip_evict(struct eve_snip *sc, int i)
+{
+	eve_gmem_free(sc->gm, sc->entries[i].mem);
+	sc->entries[i].mem = -1;
+	sc->stats.evictions++;
+}
+
+/*
+ * Number of least recently used fragments to evict before size bytes can be
+ * allocated, -1 if even evicting all of them isn't enough.
+ */
+static int
+snip_plan(struct eve_snip *sc, uint32_t size)
+{
+	uint8_t evicted[EVE_SNIP_MAX] = { 0 };
+	int i;
+
+	sc->trial = *sc->gm;
+
+	for (int n = 0;; ++n) {
+		if (eve_gmem_alloc(&sc->trial, size, 4) >= 0)
+			return n;
+		if ((i = snip_lru(sc, evicted)) < 0)
+			return -1;
+
+		evicted[i] = 1;
+		eve_gmem_free(&sc->trial, sc->entries[i].mem);
+	}
+}
+
+void
+eve_snip_init(struct eve_snip *sc, struct eve_gmem *gm)
+{
+	assert(sc);
+	assert(gm);
+
+	memset(sc, 0, sizeof (*sc));
+	sc->gm = gm;
+
+	for (int i = 0; i < EVE_SNIP_MAX; ++i)
+		sc->entries[i].mem = -1;
+}
+
+int
+eve_snip_put(struct eve_snip *sc, struct eve_cp *cp, const uint32_t *words, size_t n)
+{
+	assert(sc);
+	assert(cp);
+	assert(words || n == 0);
+
+	uint32_t size = n * 4;
+	uint64_t hash;
+	int i, mem, evict;
+
+	if (n == 0 || n > EVE_DL_MAX)
+		return -1;
+
+	hash = snip_hash(words, n);
+
+	if ((i = snip_find(sc, hash, size)) >= 0) {
+		sc->entries[i].stamp = ++sc->clock;
+		sc->stats.hits++;
+		sc->stats.bytes_saved += size;
+		return i;
+	}
+
+	/* Make room, oldest fragments first, unless it can't fit anyway. */
+	if ((evict = snip_plan(sc, size)) < 0)
+		return -1;
+
+	while (evict--)
+		snip_evict(sc, snip_lru(sc, NULL));
+
+	if ((mem = eve_gmem_alloc(sc->gm, size, 4)) < 0)
+		return -1;
+
+	for (i = 0; i < EVE_SNIP_MAX && sc->entries[i].mem >= 0; ++i)
+		continue;
+
+	if (i == EVE_SNIP_MAX)
+		snip_evict(sc, i = snip_lru(sc, NULL));
+
+	if (eve_cp_memwrite(cp, eve_gmem_address(sc->gm, mem), words, size) < 0) {
+		eve_gmem_free(sc->gm, mem);
+		return -1;
+	}
+
+	sc->entries[i].mem = mem;
+	sc->entries[i].size = size;
+	sc->entries[i].hash = hash;
+	sc->entries[i].stamp = ++sc->clock;
+	sc->stats.misses++;
+
+	return i;
+}
+
+int
+eve_snip_append(struct eve_snip *sc, struct eve_cp *cp, const uint32_t *words, size_t n)
+{
+	int i;
+
+	if ((i = eve_snip_put(sc, cp, words, n)) < 0)
+		return -1;
+
+	return eve_cp_append(cp, eve_gmem_address(sc->gm, sc->entries[i].mem), sc->entries[i].size);
+}
+
+void
+eve_snip_clear(struct eve_snip *sc)
+{
+	assert(sc);
+
+	for (int i = 0; i < EVE_SNIP_MAX; ++i) {
+		if (sc->entries[i].mem >= 0)
+			eve_gmem_free(sc->gm, sc->entries[i].mem);
+
+		sc->entries[i].mem = -1;
+	}
+}
@@ -0,0 +1,94 @@
+#ifndef EVE_SNIP_H
+#define EVE_SNIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "eve_gmem.h"
+
+/*
+ * Display list snippet cache.
+ *
+ * Fragments repeated every frame (button skins, grids, icons) are uploaded
+ * once into RAM_G and appended to the coprocessor list with CMD_APPEND, a
+ * three word command whatever the fragment size.
+ *
+ * Fragments are identified by their content: a 64-bit FNV-1a hash and the
+ * size, so the same words always resolve to the same copy in RAM_G. Memory
+ * comes from an eve_gmem allocator, when it runs short or all entries are
+ * taken the least recently used fragments are evicted. Evictions are tried
+ * on a copy of the allocator first: a fragment that wouldn't fit even once
+ * the cache is emptied, the pool being shared, evicts nothing.
+ *
+ * Uploads go through the same coprocessor stream as the CMD_APPEND using
+ * them (CMD_MEMWRITE), so memory reused after an eviction is never
+ * overwritten before earlier appends have been executed.
+ *
+ * RAM_DL resident fragments reached with CALL are not provided: the host
+ * only writes the RAM_DL buffer not being displayed so they would have to be
+ * written again after each swap.
+ */
+
+struct eve_cp;
+
+/*
+ * Maximum number of cached fragments.
+ */
+#ifndef EVE_SNIP_MAX
+#       define EVE_SNIP_MAX             32
+#endif
+
+struct eve_snip_entry {
+	int mem;                        /* eve_gmem handle, -1 if unused */
+	uint32_t size;                  /* bytes */
+	uint64_t hash;
+	uint32_t stamp;                 /* last use, for LRU */
+};
+
+struct eve_snip_stats {
+	uint32_t hits;                  /* fragments appended from the cache */
+	uint32_t misses;                /* fragments uploaded */
+	uint32_t evictions;
+	uint64_t bytes_saved;           /* fragment bytes not sent thanks to hits */
+};
+
+struct eve_snip {
+	struct eve_gmem *gm;
+	uint32_t clock;
+	struct eve_snip_stats stats;
+	struct eve_snip_entry entries[EVE_SNIP_MAX];
+	struct eve_gmem trial;          /* evictions planned on this copy */
+};
+
+/**
+ * Use gm, shared with other users, for fragment storage.
+ */
+void
+eve_snip_init(struct eve_snip *sc, struct eve_gmem *gm);
+
+/**
+ * Make sure the n words are in RAM_G, uploading them through cp if needed.
+ *
+ * Returns the entry index or -1 if the fragment doesn't fit at all. The index
+ * is only valid until the next call, which may evict it.
+ */
+int
+eve_snip_put(struct eve_snip *sc, struct eve_cp *cp, const uint32_t *words, size_t n);
+
+/**
+ * Append the n words to the coprocessor list through the cache, this is the
+ * per frame call.
+ */
+int
+eve_snip_append(struct eve_snip *sc, struct eve_cp *cp, const uint32_t *words, size_t n);
+
+/**
+ * Drop every fragment and give the memory back to the allocator.
+ *
+ * Must be called when RAM_G content was lost (device reset) and before gm is
+ * initialized again.
+ */
+void
+eve_snip_clear(struct eve_snip *sc);
+
+#endif /* !EVE_SNIP_H */
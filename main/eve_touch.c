@@ -0,0 +1,204 @@
+#if defined(EVE_ESP32)
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "eve.h"
+#include "eve_touch.h"
+
+#define TAG "eve"
+
+/* Register window holding every touch point and tag. */
+#define WINDOW          EVE_REG_CTOUCH_TOUCH1_XY
+#define WINDOW_WORDS    ((EVE_REG_CTOUCH_TOUCH3_XY - WINDOW) / 4 + 1)
+
+/* Word of reg in the window. */
+#define WORD(reg)       (((reg) - WINDOW) / 4)
+
+/* Sampling period in ticks, at least one. */
+#define POLL_TICKS      (pdMS_TO_TICKS(EVE_TOUCH_POLL_MS) ? pdMS_TO_TICKS(EVE_TOUCH_POLL_MS) : 1)
+
+/* Coordinate reported for a point not touched. */
+#define NO_TOUCH        (-32768)
+
+static const struct {
+	uint32_t xy;                    /* x in the upper half, y in the lower */
+	uint32_t tag;
+} points[EVE_TOUCH_MAX - 1] = {
+	{ EVE_REG_CTOUCH_TOUCH0_XY, EVE_REG_TOUCH_TAG  },
+	{ EVE_REG_CTOUCH_TOUCH1_XY, EVE_REG_TOUCH_TAG1 },
+	{ EVE_REG_CTOUCH_TOUCH2_XY, EVE_REG_TOUCH_TAG2 },
+	{ EVE_REG_CTOUCH_TOUCH3_XY, EVE_REG_TOUCH_TAG3 },
+};
+
+static void
+touch_emit(struct eve_touch *touch,
+           enum eve_touch_type type,
+           uint8_t id,
+           const struct eve_touch_point *pt,
+           int64_t now_us)
+{
+	struct eve_touch_event ev = {
+		.time_us = now_us,
+		.type    = type,
+		.id      = id,
+		.tag     = pt->tag,
+		.x       = pt->x,
+		.y       = pt->y,
+	};
+
+	if (xQueueSend(touch->events, &ev, 0) != pdTRUE)
+		touch->dropped++;
+}
+
+static void
+touch_update(struct eve_touch *touch, uint8_t id, int16_t x, int16_t y, uint8_t tag, int64_t now_us)
+{
+	struct eve_touch_point *pt = &touch->points[id];
+	int down = x != NO_TOUCH;
+
+	if (down && !pt->down) {
+		pt->down = 1;
+		pt->x = x;
+		pt->y = y;
+		pt->tag = tag;
+		touch_emit(touch, EVE_TOUCH_PRESS, id, pt, now_us);
+	} else if (down) {
+		if (abs(x - pt->x) < EVE_TOUCH_DRAG_MIN && abs(y - pt->y) < EVE_TOUCH_DRAG_MIN)
+			return;
+
+		/* Held back, the next drag reports the motion. */
+		if (uxQueueSpacesAvailable(touch->events) <= EVE_TOUCH_RESERVE)
+			return;
+
+		pt->x = x;
+		pt->y = y;
+		pt->tag = tag;
+		touch_emit(touch, EVE_TOUCH_DRAG, id, pt, now_us);
+	} else if (pt->down) {
+		/* Reported where the point was last seen. */
+		pt->down = 0;
+		touch_emit(touch, EVE_TOUCH_RELEASE, id, pt, now_us);
+	}
+}
+
+/*
+ * Returns whether any point is still touched.
+ */
+static int
+touch_sample(struct eve_touch *touch, const uint32_t *window, int64_t now_us)
+{
+	uint32_t xy;
+	int touched = 0;
+
+	for (uint8_t i = 0; i < EVE_TOUCH_MAX - 1; ++i) {
+		xy = window[WORD(points[i].xy)];
+		touch_update(touch, i, xy >> 16, xy & 0xffff, window[WORD(points[i].tag)] & 0xff, now_us);
+	}
+
+	/* The fifth point has its coordinates in two registers and no tag. */
+	touch_update(touch,
+	             EVE_TOUCH_MAX - 1,
+	             window[WORD(EVE_REG_CTOUCH_TOUCH4_X)] & 0xffff,
+	             window[WORD(EVE_REG_CTOUCH_TOUCH4_Y)] & 0xffff,
+	             window[WORD(EVE_REG_TOUCH_TAG4)] & 0xff,
+	             now_us);
+
+	for (size_t i = 0; i < EVE_TOUCH_MAX; ++i)
+		touched |= touch->points[i].down;
+
+	return touched;
+}
+
+static void
+touch_task(void *data)
+{
+	struct eve_touch *touch = data;
+	uint32_t window[WINDOW_WORDS];
+	int touched = 0, rc;
+
+	while (!atomic_load(&touch->stop)) {
+		rc = eve_irq_wait(touch->devc,
+		                  EVE_IRQ_TOUCH | EVE_IRQ_TAG,
+		                  touched ? EVE_TOUCH_POLL_MS : EVE_TOUCH_IDLE_MS);
+
+		if (rc < 0)
+			vTaskDelay(POLL_TICKS);
+		else if (rc == 0 && !touched)
+			continue;
+
+		if (eve_read(touch->devc, WINDOW, window, sizeof (window)) < 0)
+			continue;
+
+		touch->samples++;
+		touched = touch_sample(touch, window, esp_timer_get_time());
+	}
+
+	xTaskNotifyGive(touch->closer);
+	vTaskDelete(NULL);
+}
+
+int
+eve_touch_open(struct eve_touch *touch, intptr_t devc, size_t queue_size, int prio)
+{
+	assert(touch);
+
+	memset(touch, 0, sizeof (*touch));
+	touch->devc = devc;
+	touch->events_size = queue_size > EVE_TOUCH_RESERVE ? queue_size : EVE_TOUCH_RESERVE + 1;
+
+	/* 0 selects extended mode, the default only reports one point. */
+	if (eve_write8(devc, EVE_REG_CTOUCH_EXTENDED, 0) < 0)
+		return -1;
+
+	if (!(touch->events = xQueueCreate(touch->events_size, sizeof (struct eve_touch_event)))) {
+		ESP_LOGW(TAG, "unable to create touch queue");
+		return -1;
+	}
+
+	if (xTaskCreate(touch_task, "eve-touch", 3072, touch, prio, &touch->task) != pdPASS) {
+		ESP_LOGW(TAG, "unable to create touch task");
+		vQueueDelete(touch->events);
+		touch->events = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+int
+eve_touch_get(struct eve_touch *touch, struct eve_touch_event *event, uint32_t timeout_ms)
+{
+	assert(touch);
+	assert(event);
+
+	TickType_t ticks;
+
+	ticks = timeout_ms == EVE_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+	return xQueueReceive(touch->events, event, ticks) == pdTRUE ? 0 : -1;
+}
+
+void
+eve_touch_close(struct eve_touch *touch)
+{
+	assert(touch);
+
+	if (!touch->task)
+		return;
+
+	/* The task notices within EVE_TOUCH_IDLE_MS. */
+	touch->closer = xTaskGetCurrentTaskHandle();
+	atomic_store(&touch->stop, 1);
+	ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+	vQueueDelete(touch->events);
+	touch->task = NULL;
+	touch->events = NULL;
+}
+
+#endif /* !EVE_ESP32 */
@@ -0,0 +1,109 @@
+#ifndef EVE_TOUCH_H
+#define EVE_TOUCH_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+/*
+ * Multi-touch input from the capacitive touch engine.
+ *
+ * The five touch points and their tags are spread over
+ * EVE_REG_CTOUCH_TOUCH1_XY to EVE_REG_CTOUCH_TOUCH3_XY, a task reads that
+ * whole window in a single burst per sample. Sampling is triggered by
+ * EVE_IRQ_TOUCH and EVE_IRQ_TAG, then continues at EVE_TOUCH_POLL_MS while
+ * anything is touched to catch releases.
+ *
+ * Samples are turned into press, drag and release events per touch point.
+ * Drags below EVE_TOUCH_DRAG_MIN pixels are coalesced into the next one, as
+ * are drags while the event queue is almost full so that presses and
+ * releases are never the ones lost.
+ */
+
+/* Number of simultaneous touch points. */
+#define EVE_TOUCH_MAX                   5
+
+/*
+ * Sampling period while touched, and how long the task waits for an
+ * interrupt before checking whether it was asked to stop.
+ */
+#ifndef EVE_TOUCH_POLL_MS
+#       define EVE_TOUCH_POLL_MS        10
+#endif
+
+#ifndef EVE_TOUCH_IDLE_MS
+#       define EVE_TOUCH_IDLE_MS        100
+#endif
+
+/*
+ * Minimal motion in pixels on either axis reported as a drag.
+ */
+#ifndef EVE_TOUCH_DRAG_MIN
+#       define EVE_TOUCH_DRAG_MIN       2
+#endif
+
+/*
+ * Queue slots kept free for presses and releases.
+ */
+#ifndef EVE_TOUCH_RESERVE
+#       define EVE_TOUCH_RESERVE        4
+#endif
+
+enum eve_touch_type {
+	EVE_TOUCH_PRESS,
+	EVE_TOUCH_DRAG,
+	EVE_TOUCH_RELEASE
+};
+
+struct eve_touch_event {
+	int64_t time_us;                /* sample time */
+	uint8_t type;
+	uint8_t id;                     /* touch point, 0 to EVE_TOUCH_MAX - 1 */
+	uint8_t tag;                    /* tag under the point */
+	int16_t x;
+	int16_t y;
+};
+
+struct eve_touch_point {
+	int down;
+	int16_t x;
+	int16_t y;
+	uint8_t tag;
+};
+
+struct eve_touch {
+	intptr_t devc;
+	QueueHandle_t events;
+	size_t events_size;
+	TaskHandle_t task;
+	TaskHandle_t closer;
+	atomic_int stop;
+	struct eve_touch_point points[EVE_TOUCH_MAX];
+	uint32_t samples;               /* burst reads done */
+	uint32_t dropped;               /* events lost, queue full */
+};
+
+/**
+ * Switch the touch engine to extended (multi-touch) mode and start sampling,
+ * events are buffered in a queue of queue_size entries.
+ *
+ * EVE_IRQ_TOUCH and EVE_IRQ_TAG must be part of the eve_irq_enable mask when
+ * the interrupt line is wired, the touch points are polled otherwise.
+ */
+int
+eve_touch_open(struct eve_touch *touch, intptr_t devc, size_t queue_size, int prio);
+
+/**
+ * Wait for the next event, returns -1 on timeout.
+ */
+int
+eve_touch_get(struct eve_touch *touch, struct eve_touch_event *event, uint32_t timeout_ms);
+
+void
+eve_touch_close(struct eve_touch *touch);
+
+#endif /* !EVE_TOUCH_H */
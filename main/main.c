@@ -1,24 +1,66 @@
 #include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <esp_console.h>
 #include <esp_log.h>
 #include <esp_err.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
 
 #include <driver/spi_master.h>
 
 #include "eve.h"
+#include "eve_asset.h"
+#include "eve_audio.h"
 #include "eve_esp32.h"
+#include "eve_flash.h"
+#include "eve_font.h"
+#include "eve_scene.h"
+#include "eve_snap.h"
+#include "eve_frame.h"
+#include "eve_idle.h"
+#include "eve_touch.h"
 #include "sysconfig.h"
 
 #define TAG                     "main"
 
 #define PB_SPI_CLOCK_SPEED      10000000
 #define PB_SPI_QUEUE_SIZE       4
-#define PB_SPI_XFER_SIZE_MAX    128
+#define PB_SPI_XFER_SIZE_MAX    16384
+#define PB_SPI_SLICE_SIZE       4096
 #define PB_SPI_HOST             SPI2_HOST
 
+#define PB_LCD_PRIO             5
+#define PB_LCD_FRAME_BUFS       2
+#define PB_LCD_SPLASH_MS        100
+#define PB_TOUCH_PRIO           6
+#define PB_TOUCH_QUEUE_SIZE     16
+#define PB_AUDIO_RING           0xf8000
+#define PB_AUDIO_RING_SIZE      8192
+#define PB_AUDIO_FREQ           8000
+#define PB_BEEP_HZ              1000
+#define PB_BEEP_MS              200
+#define PB_SNAP_STAGING         0x80000
+#define PB_SNAP_STAGING_SIZE    0x40000
+#define PB_IDLE_DIM_MS          30000
+#define PB_IDLE_STANDBY_MS      60000
+#define PB_IDLE_SLEEP_MS        300000
+#define PB_IDLE_DIM_DUTY        16
+#define PB_IDLE_POLL_MS         50
+#define PB_IDLE_HOLD_MS         500     /* console waiting for the device */
+#define PB_ASSET_PART           "assets"        /* see partitions.csv */
+#define PB_ASSET_LOGO           "logo.png"
+#define PB_ASSET_LOGO_ADDR      0x00000         /* RAM_G */
+#define PB_ASSET_LOGO_SIZE      PB_SNAP_STAGING /* up to the staging area */
+
+#define PB_CONSOLE_PROMPT       "pb> "
+
 /* Verify all that stuff? */
 #define PB_LCD_60MHZ            0x3938700
 #define PB_LCD_HSIZE            800
@@ -36,6 +78,22 @@
 
 static struct {
 	intptr_t lcd;
+	int lcd_ready;
+	struct eve_frame frame;
+	struct eve_touch touch;
+	struct eve_touch_point points[EVE_TOUCH_MAX];
+	uint32_t flash_result;          /* CMD_FLASHFAST result */
+	struct eve_audio audio;
+	uint32_t beep_left;             /* samples */
+	atomic_int beep;                /* requested from the console */
+	struct eve_scene scene;
+	int status;                     /* scene nodes */
+	int progress;
+	struct eve_idle idle;
+	atomic_int wake;                /* requested from the console */
+	atomic_int busy;                /* console command needs the device */
+	atomic_int held;                /* busy seen, idle states held off */
+	atomic_int awake;               /* device reachable */
 } pb;
 
 static void
@@ -61,26 +119,52 @@ init_spi(void)
 	bus_conf.quadhd_io_num   = -1;
 	bus_conf.max_transfer_sz = PB_SPI_XFER_SIZE_MAX;
 
-	/* TODO: check DMA. */
+#if PB_SCONF_SPI_WIDTH == 4
+	bus_conf.quadwp_io_num   = PB_SCONF_PIN_IO2;
+	bus_conf.quadhd_io_num   = PB_SCONF_PIN_IO3;
+	bus_conf.flags           = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_QUAD;
+#endif
+
+	/*
+	 * DMA lets a single transaction carry up to PB_SPI_XFER_SIZE_MAX
+	 * bytes and queued transactions run without the CPU.
+	 */
 	ESP_LOGI(TAG, "initializing SPI bus");
-	err = spi_bus_initialize(PB_SPI_HOST, &bus_conf, SPI_DMA_DISABLED);
+	err = spi_bus_initialize(PB_SPI_HOST, &bus_conf, SPI_DMA_CH_AUTO);
 	ESP_ERROR_CHECK(err);
 }
 
+/*
+ * Sleep for the given amount of microseconds, delays shorter than a tick
+ * are spun.
+ */
 static void
+delay_us(int64_t us)
+{
+	if (us < portTICK_PERIOD_MS * 1000)
+		esp_rom_delay_us(us);
+	else
+		vTaskDelay(pdMS_TO_TICKS(us / 1000));
+}
+
+static int
 init_lcd_spi(void)
 {
 	struct eve_cfg cfg = {};
-	uint8_t id = 0xff;
-	uint16_t status = 0xffff;
+	struct eve_boot boot;
+	int64_t delay;
 
 	ESP_LOGI(TAG, "initializing LCD over SPI");
 
-	cfg.pin_cs        = PB_SCONF_PIN_CS;
-	cfg.pin_pd        = PB_SCONF_PIN_PD;
-	cfg.spi_clk_speed = PB_SPI_CLOCK_SPEED;
-	cfg.spi_host      = PB_SPI_HOST;
-	cfg.queue_size    = PB_SPI_QUEUE_SIZE;
+	cfg.pin_cs         = PB_SCONF_PIN_CS;
+	cfg.pin_pd         = PB_SCONF_PIN_PD;
+	cfg.pin_int        = PB_SCONF_PIN_INT;
+	cfg.spi_clk_speed  = PB_SPI_CLOCK_SPEED;
+	cfg.spi_host       = PB_SPI_HOST;
+	cfg.queue_size     = PB_SPI_QUEUE_SIZE;
+	cfg.spi_xfer_size  = PB_SPI_XFER_SIZE_MAX;
+	cfg.spi_width      = PB_SCONF_SPI_WIDTH;
+	cfg.spi_slice_size = PB_SPI_SLICE_SIZE;
 
 	/*
 	 * This function will initialize appropriates GPIO as output and turn
@@ -89,76 +173,735 @@ init_lcd_spi(void)
 	pb.lcd = eve_init(&cfg);
 	assert(pb.lcd);
 
-	/* Turn back on. */
-	vTaskDelay(pdMS_TO_TICKS(50));
-	eve_power(pb.lcd, 1);
-	vTaskDelay(pdMS_TO_TICKS(50));
+	/* Power sequence, activation and readiness checks. */
+	delay = eve_boot_init(&boot, pb.lcd, esp_timer_get_time());
 
-	/* Now activate core. */
-	eve_cmd(pb.lcd, EVE_CMD_RST_PULSE, 0);
-	eve_cmd(pb.lcd, EVE_CMD_ACTIVE, 0);
-
-	/* Wait until it's ready. */
-	while (id != 0x7c) {
-		eve_read8(pb.lcd, EVE_REG_ID, &id);
-		vTaskDelay(pdMS_TO_TICKS(500));
+	while (delay) {
+		delay_us(delay);
+		delay = eve_boot_step(&boot, esp_timer_get_time());
 	}
 
-	ESP_LOGI(TAG, "LCD ready");
+	ESP_LOGI(TAG, "LCD boot %s after %d retries:",
+	    boot.state == EVE_BOOT_DONE ? "done" : "failed", (int)boot.retries);
+	ESP_LOGI(TAG, "  - power on:  %lld us", (long long)boot.stamps[EVE_BOOT_POWER_ON]);
+	ESP_LOGI(TAG, "  - active:    %lld us", (long long)boot.stamps[EVE_BOOT_WAIT_ID]);
+	ESP_LOGI(TAG, "  - ID ready:  %lld us", (long long)boot.stamps[EVE_BOOT_WAIT_RESET]);
+	ESP_LOGI(TAG, "  - CPU ready: %lld us", (long long)boot.stamps[EVE_BOOT_DONE]);
 
-	/* Check reset status. */
-	while (status != 0x00) {
-		eve_read16(pb.lcd, EVE_REG_CPURESET, &status);
-		vTaskDelay(pdMS_TO_TICKS(25));
-	}
+	if (boot.state != EVE_BOOT_DONE)
+		return -1;
 
-	ESP_LOGI(TAG, "LCD CPU state ready");
+	/* Interrupts the driver waits on, ignored if INT is not wired. */
+	eve_irq_enable(pb.lcd,
+	               EVE_IRQ_SWAP | EVE_IRQ_CMDEMPTY | EVE_IRQ_CMDFLAG |
+	               EVE_IRQ_TOUCH | EVE_IRQ_TAG);
+
+	/* Negotiate more data lines if wired, stays single line on failure. */
+	if (PB_SCONF_SPI_WIDTH > 1)
+		eve_set_width(pb.lcd, PB_SCONF_SPI_WIDTH);
 
 	/* Make sure to operate at 60Mhz. */
 	eve_write32(pb.lcd, EVE_REG_FREQUENCY, PB_LCD_60MHZ);
+
+	return 0;
+}
+
+/*
+ * Splash screen, a constant coprocessor stream in flash shown with a single
+ * burst as soon as the panel is set up.
+ */
+static const uint32_t splash[] = {
+	EVE_CPC_DLSTART,
+	EVE_DL_CLEAR_COLOR_RGB(0x00, 0x00, 0x00),
+	EVE_DL_CLEAR(1, 1, 1),
+	EVE_DL_COLOR_RGB(0x00, 0x0f, 0xf0),
+	EVE_DL_LINE_WIDTH(8 * 16),
+	EVE_DL_BEGIN(EVE_PRIM_RECTS),
+	EVE_DL_VERTEX2F((PB_LCD_HSIZE / 2 - 64) * 16, (PB_LCD_VSIZE / 2 - 64) * 16),
+	EVE_DL_VERTEX2F((PB_LCD_HSIZE / 2 + 64) * 16, (PB_LCD_VSIZE / 2 + 64) * 16),
+	EVE_DL_END(),
+	EVE_DL_DISPLAY(),
+	EVE_CPC_SWAP,
+};
+
+/* Start of every frame, never encoded at run time. */
+static const uint32_t chrome[] = {
+	EVE_DL_CLEAR_COLOR_RGB(0x00, 0x0f, 0xf0),
+	EVE_DL_CLEAR(1, 1, 1),
+	EVE_DL_POINT_SIZE(40 * 16),
+};
+
+/*
+ * Status bar at the bottom of the screen, text in ROM font 18 (8x16).
+ */
+static void
+init_scene(void)
+{
+	eve_scene_init(&pb.scene);
+	eve_scene_rect(&pb.scene, 0, 0, PB_LCD_VSIZE - 24, PB_LCD_HSIZE, 24, 0xff000000, 0);
+	pb.status = eve_scene_text(&pb.scene, 1, 8, PB_LCD_VSIZE - 20, 18, 8, 0xffffffff, "");
+	pb.progress = eve_scene_gauge(&pb.scene,
+	                              1,
+	                              PB_LCD_HSIZE - 208,
+	                              PB_LCD_VSIZE - 18,
+	                              200,
+	                              12,
+	                              0xff404040,
+	                              0xff00c000,
+	                              59);
+}
+
+/* Basic list clearing to full blue, with a dot under each finger. */
+static void
+render(void *arg, struct eve_dl *dl, uint32_t frame)
+{
+	struct eve_touch_event ev;
+	char status[EVE_SCENE_TEXT_MAX];
+
+	(void)arg;
+
+	while (pb.touch.task && eve_touch_get(&pb.touch, &ev, 0) == 0) {
+		pb.points[ev.id].down = ev.type != EVE_TOUCH_RELEASE;
+		pb.points[ev.id].x = ev.x;
+		pb.points[ev.id].y = ev.y;
+		eve_idle_activity(&pb.idle, ev.time_us);
+	}
+
+	eve_dl_append(dl, chrome, sizeof (chrome) / sizeof (chrome[0]));
+	eve_dl_begin(dl, EVE_PRIM_POINTS);
+	for (size_t i = 0; i < EVE_TOUCH_MAX; ++i)
+		if (pb.points[i].down)
+			eve_dl_vertex2f(dl, pb.points[i].x * 16, pb.points[i].y * 16);
+	eve_dl_end(dl);
+
+	/* Same length every frame, both updates are patched in place. */
+	snprintf(status, sizeof (status), "frame %08lu", (unsigned long)frame);
+	eve_scene_set_text(&pb.scene, pb.status, status);
+	eve_scene_set_value(&pb.scene, pb.progress, frame % 60);
+	eve_scene_render(&pb.scene, dl);
+
+	eve_dl_display(dl);
 }
 
 static void
 init_lcd_specs(void)
 {
+	struct eve_reg timings[] = {
+		{ EVE_REG_HSIZE,    PB_LCD_HSIZE   },
+		{ EVE_REG_HCYCLE,   PB_LCD_HCYCLE  },
+		{ EVE_REG_HOFFSET,  PB_LCD_HOFFSET },
+		{ EVE_REG_HSYNC0,   PB_LCD_HSYNC0  },
+		{ EVE_REG_HSYNC1,   PB_LCD_HSYNC1  },
+		{ EVE_REG_VSIZE,    PB_LCD_VSIZE   },
+		{ EVE_REG_VCYCLE,   PB_LCD_VCYCLE  },
+		{ EVE_REG_VOFFSET,  PB_LCD_VOFFSET },
+		{ EVE_REG_VSYNC0,   PB_LCD_VSYNC0  },
+		{ EVE_REG_VSYNC1,   PB_LCD_VSYNC1  },
+		{ EVE_REG_PCLK_POL, PB_LCD_PCLKPOL }
+	};
 
 	/*
 	 * Adafruit 1680:
 	 *
 	 * - 800x480
+	 *
+	 * HCYCLE to VSYNC1 are contiguous and are sent in one burst, PCLK_POL
+	 * needs a second one.
 	 */
-	eve_write16(pb.lcd, EVE_REG_HSIZE,    PB_LCD_HSIZE);
-	eve_write16(pb.lcd, EVE_REG_HCYCLE,   PB_LCD_HCYCLE);
-	eve_write16(pb.lcd, EVE_REG_HOFFSET,  PB_LCD_HOFFSET);
-	eve_write16(pb.lcd, EVE_REG_HSYNC0,   PB_LCD_HSYNC0);
-	eve_write16(pb.lcd, EVE_REG_HSYNC1,   PB_LCD_HSYNC1);
-	eve_write16(pb.lcd, EVE_REG_VSIZE,    PB_LCD_VSIZE);
-	eve_write16(pb.lcd, EVE_REG_VCYCLE,   PB_LCD_VCYCLE);
-	eve_write16(pb.lcd, EVE_REG_VOFFSET,  PB_LCD_VOFFSET);
-	eve_write16(pb.lcd, EVE_REG_VSYNC0,   PB_LCD_VSYNC0);
-	eve_write16(pb.lcd, EVE_REG_VSYNC1,   PB_LCD_VSYNC1);
-	eve_write8(pb.lcd,  EVE_REG_PCLK_POL, PB_LCD_PCLKPOL);
+	eve_writev(pb.lcd, timings, sizeof (timings) / sizeof (timings[0]));
+
 #if 0
 	eve_write8(REG_SWIZZLE, EVE_SWIZZLE);
 	eve_write8(REG_CSPREAD, EVE_CSPREAD);
 #endif
 
-	/* Add a basic DL list command to clear to full blue. */
-	eve_write32(pb.lcd, EVE_MAP_RAM_DL +  0, EVE_DLC_CLEAR_COLOR_RGB | 0x00000ff0);
-	eve_write32(pb.lcd, EVE_MAP_RAM_DL +  4, EVE_DLC_CLEAR | EVE_CLEAR_COLOR | EVE_CLEAR_TAG | EVE_CLEAR_STENCIL);
-	eve_write32(pb.lcd, EVE_MAP_RAM_DL +  8, EVE_DLC_DISPLAY);
-	eve_write8(pb.lcd, EVE_REG_DLSWAP, 0x2);
+	init_scene();
+
+	/* Splash is ready before the display is turned on. */
+	eve_cp_send(pb.lcd, splash, sizeof (splash) / sizeof (splash[0]));
+
+	eve_frame_init(&pb.frame,
+	               pb.lcd,
+	               PB_LCD_FRAME_BUFS,
+	               eve_frame_period_us(PB_LCD_HCYCLE, PB_LCD_VCYCLE, PB_LCD_PCLK, PB_LCD_60MHZ),
+	               render,
+	               NULL,
+	               esp_timer_get_time());
 
 	/* turn on the screen (enable DISP) */
 	eve_write8(pb.lcd, EVE_REG_GPIO, 0x80);
 	eve_write8(pb.lcd, EVE_REG_PCLK, PB_LCD_PCLK);
+
+	/* Frames go to RAM_DL directly, don't overwrite the splash before it shows. */
+	eve_wait_cmdempty(pb.lcd, PB_LCD_SPLASH_MS);
+	eve_wait_swap(pb.lcd, PB_LCD_SPLASH_MS);
 }
 
+/*
+ * Images packed by tools/evepack.py into the assets partition are decoded
+ * into RAM_G once, the partition may be left empty.
+ */
 static void
-init_lcd(void)
+init_lcd_assets(void)
+{
+	static struct eve_cp cp;
+	struct eve_asset_pack pack;
+	const struct eve_asset_entry *logo;
+
+	if (eve_asset_open(&pack, PB_ASSET_PART) < 0)
+		return;
+
+	for (uint32_t i = 0; i < pack.count; ++i)
+		ESP_LOGI(TAG, "  - %.*s: %lu bytes",
+		    EVE_ASSET_NAME_MAX, pack.entries[i].name, (unsigned long)pack.entries[i].raw_size);
+
+	eve_cp_init(&cp, pb.lcd);
+
+	/* Decoded it must not run into the snapshot staging area. */
+	if (!(logo = eve_asset_find(&pack, PB_ASSET_LOGO)))
+		;
+	else if (logo->raw_size > PB_ASSET_LOGO_SIZE)
+		ESP_LOGW(TAG, PB_ASSET_LOGO " too large: %lu bytes, %lu available",
+		    (unsigned long)logo->raw_size, (unsigned long)PB_ASSET_LOGO_SIZE);
+	else if (eve_asset_load(&pack, logo, &cp, PB_ASSET_LOGO_ADDR, 0) < 0 || eve_cp_wait(&cp) < 0)
+		ESP_LOGW(TAG, "unable to load " PB_ASSET_LOGO);
+
+	eve_asset_close(&pack);
+}
+
+/*
+ * Assets are drawn from flash once it is in fast mode, which needs a
+ * programmed image (tools/eveflash.py).
+ */
+static void
+init_lcd_flash(void)
+{
+	static struct eve_cp cp;
+
+	eve_cp_init(&cp, pb.lcd);
+
+	if (eve_flash_attach(&cp) < 0) {
+		ESP_LOGW(TAG, "no flash attached");
+		return;
+	}
+
+	if (eve_flash_fast(&cp, &pb.flash_result) < 0)
+		ESP_LOGW(TAG, "flash not in fast mode: 0x%04lx", (unsigned long)pb.flash_result);
+}
+
+/*
+ * Square wave at PB_BEEP_HZ, signed 8-bit samples.
+ */
+static size_t
+beep_fill(void *arg, void *buf, size_t size)
+{
+	static const uint32_t period = PB_AUDIO_FREQ / PB_BEEP_HZ;
+	int8_t *samples = buf;
+	size_t n = size < pb.beep_left ? size : pb.beep_left;
+
+	(void)arg;
+
+	for (size_t i = 0; i < n; ++i)
+		samples[i] = (pb.beep_left - i) % period < period / 2 ? 64 : -64;
+
+	pb.beep_left -= n;
+
+	return n;
+}
+
+/*
+ * The device can't be accessed in standby or sleep: touch sampling stops
+ * before the host command is sent and until it is awake again, frames
+ * resume without counting the pause.
+ */
+static void
+lcd_awake(void *arg, int awake)
+{
+	(void)arg;
+
+	if (!awake) {
+		eve_touch_close(&pb.touch);
+		return;
+	}
+
+	ESP_LOGI(TAG, "LCD awake after %lld us", (long long)pb.idle.stats.wake_last_us);
+
+	eve_frame_resume(&pb.frame, esp_timer_get_time());
+
+	if (eve_touch_open(&pb.touch, pb.lcd, PB_TOUCH_QUEUE_SIZE, PB_TOUCH_PRIO) < 0)
+		ESP_LOGW(TAG, "touch unavailable");
+}
+
+/*
+ * The LCD boots in its own task so that the rest of the system comes up in
+ * parallel, the task then keeps rendering frames.
+ */
+static void
+lcd_task(void *data)
 {
-	init_lcd_spi();
+	int64_t delay, audio, idle;
+	int busy;
+
+	(void)data;
+
+	if (init_lcd_spi() < 0) {
+		ESP_LOGE(TAG, "LCD unavailable");
+		vTaskDelete(NULL);
+		return;
+	}
+
 	init_lcd_specs();
+	init_lcd_flash();
+	init_lcd_assets();
+	pb.lcd_ready = 1;
+
+	if (eve_touch_open(&pb.touch, pb.lcd, PB_TOUCH_QUEUE_SIZE, PB_TOUCH_PRIO) < 0)
+		ESP_LOGW(TAG, "touch unavailable");
+
+	eve_audio_init(&pb.audio, pb.lcd, PB_AUDIO_RING, PB_AUDIO_RING_SIZE, beep_fill, NULL);
+	eve_write8(pb.lcd, EVE_REG_VOL_PB, 0xff);
+
+	if (eve_idle_init(&pb.idle,
+	                  pb.lcd,
+	                  PB_IDLE_DIM_MS * 1000LL,
+	                  PB_IDLE_STANDBY_MS * 1000LL,
+	                  PB_IDLE_SLEEP_MS * 1000LL,
+	                  PB_IDLE_DIM_DUTY,
+	                  lcd_awake,
+	                  NULL,
+	                  esp_timer_get_time()) < 0)
+		ESP_LOGW(TAG, "panel state unknown, idle disabled");
+
+	for (;;) {
+		/* A pending beep or console command keeps the device awake. */
+		busy = atomic_load(&pb.busy);
+
+		if (atomic_exchange(&pb.wake, 0) || atomic_load(&pb.beep) || busy)
+			eve_idle_activity(&pb.idle, esp_timer_get_time());
+
+		idle = eve_idle_step(&pb.idle, esp_timer_get_time());
+
+		/* Held once a step ran after the activity, see cmd_eve. */
+		atomic_store(&pb.awake, eve_idle_awake(&pb.idle));
+		atomic_store(&pb.held, busy);
+
+		/* Only the console wakes it up from there. */
+		if (!eve_idle_awake(&pb.idle)) {
+			if (!idle || idle > PB_IDLE_POLL_MS * 1000)
+				idle = PB_IDLE_POLL_MS * 1000;
+
+			delay_us(idle);
+			continue;
+		}
+
+		if (atomic_exchange(&pb.beep, 0)) {
+			pb.beep_left = PB_AUDIO_FREQ * PB_BEEP_MS / 1000;
+			eve_audio_play(&pb.audio, EVE_SAMPLES_LINEAR, PB_AUDIO_FREQ, esp_timer_get_time());
+		}
+
+		delay = eve_frame_step(&pb.frame, esp_timer_get_time());
+		audio = eve_audio_step(&pb.audio, esp_timer_get_time());
+
+		if (audio && audio < delay)
+			delay = audio;
+		if (idle && idle < delay)
+			delay = idle;
+
+		/* Never spin here, sleep at least a tick. */
+		if (eve_frame_wait(&pb.frame, delay) < 0)
+			vTaskDelay(delay >= portTICK_PERIOD_MS * 1000 ? pdMS_TO_TICKS(delay / 1000) : 1);
+	}
+}
+
+static void
+init_lcd(void)
+{
+	xTaskCreate(lcd_task, "lcd", 4096, NULL, PB_LCD_PRIO, NULL);
+}
+
+/* Console. */
+
+#if defined(EVE_ESP32_STATS)
+
+static void
+cmd_eve_stats(void)
+{
+	static const char *ops[EVE_ESP32_OP_MAX] = { "read", "write", "cmd", "async" };
+	struct eve_esp32_stats stats;
+
+	eve_esp32_stats(pb.lcd, &stats);
+
+	printf("transactions:  %lu\n", (unsigned long)stats.transactions);
+	printf("bytes read:    %llu\n", (unsigned long long)stats.bytes_read);
+	printf("bytes written: %llu\n", (unsigned long long)stats.bytes_written);
+	printf("bus wait:      %llu us\n", (unsigned long long)stats.acquire_us);
+	printf("errors:        %lu\n", (unsigned long)stats.errors);
+
+	/* Column i counts operations under 2^i us, the last one the rest. */
+	printf("latency (us):");
+	for (int i = 0; i < EVE_ESP32_HIST_MAX - 1; ++i)
+		printf(" %6lu", 1UL << i);
+	printf("   more\n");
+
+	for (int op = 0; op < EVE_ESP32_OP_MAX; ++op) {
+		printf("  %-11s", ops[op]);
+		for (int i = 0; i < EVE_ESP32_HIST_MAX; ++i)
+			printf(" %6lu", (unsigned long)stats.hist[op][i]);
+		printf("\n");
+	}
+}
+
+#endif
+
+static int
+snap_dump(void *arg, uint32_t offset, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+
+	(void)arg;
+
+	printf("snap %08lx ", (unsigned long)offset);
+
+	for (size_t i = 0; i < size; ++i)
+		printf("%02x", p[i]);
+
+	printf("\n");
+
+	return 0;
+}
+
+/*
+ * Capture the whole screen in RGB565. The dump is turned back into an image
+ * by tools/evesnap.py, a CRC given as argument is checked.
+ */
+static int
+cmd_eve_snap(int argc, char **argv)
+{
+	static struct eve_cp cp;
+	static struct eve_snap snap;
+	int dump = argc >= 3 && strcmp(argv[2], "dump") == 0;
+	int64_t start, us;
+
+	eve_cp_init(&cp, pb.lcd);
+
+	if (eve_snap_init(&snap,
+	                  &cp,
+	                  PB_SNAP_STAGING,
+	                  PB_SNAP_STAGING_SIZE,
+	                  EVE_FORMAT_RGB565,
+	                  0,
+	                  0,
+	                  PB_LCD_HSIZE,
+	                  PB_LCD_VSIZE) < 0)
+		return 1;
+
+	if (dump)
+		printf("snap %d %d rgb565\n", PB_LCD_HSIZE, PB_LCD_VSIZE);
+
+	start = esp_timer_get_time();
+
+	if (eve_snap_capture(&snap, dump ? snap_dump : NULL, NULL) < 0) {
+		printf("capture failed\n");
+		return 1;
+	}
+
+	us = esp_timer_get_time() - start;
+
+	printf("snap crc %08lx\n", (unsigned long)snap.crc);
+
+	if (dump)
+		return 0;
+
+	printf("bytes: %lu\n", (unsigned long)snap.bytes);
+	printf("time:  %lld us (%lld kB/s)\n", (long long)us, (long long)(us ? snap.bytes * 1000LL / us : 0));
+
+	if (argc >= 3 && strtoul(argv[2], NULL, 16) != snap.crc) {
+		printf("mismatch, expected %s\n", argv[2]);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Cost of 1000 characters, 40 labels of 25, as glyph runs and as CMD_TEXT.
+ */
+static int
+cmd_eve_text(void)
+{
+	static const char label[] = "Temp 12.5 C, pressure ok.";
+	static struct eve_dl dl;
+	struct eve_font font;
+	size_t cp_bytes = 0;
+	int64_t start, us;
+#if defined(EVE_ESP32_STATS)
+	struct eve_esp32_stats before, after;
+#endif
+
+	if (eve_font_rom(&font, pb.lcd, 18) < 0)
+		return 1;
+
+	start = esp_timer_get_time();
+
+	eve_dl_init(&dl);
+	eve_font_begin(&dl);
+	for (int i = 0; i < 40; ++i)
+		eve_font_run(&dl, &font, i % 2 * 400, i / 2 * 20, label, sizeof (label) - 1);
+	eve_font_end(&dl);
+
+	us = esp_timer_get_time() - start;
+
+	/* Command, position, font and options then the padded string. */
+	for (int i = 0; i < 40; ++i)
+		cp_bytes += 12 + ((sizeof (label) + 3) & ~3);
+
+	printf("glyph runs: %lu words, %lld us to build\n", (unsigned long)dl.len, (long long)us);
+
+	/*
+	 * The list goes to scratch RAM_G, not RAM_DL which the frames use. The
+	 * lock keeps their uploads out of the counters.
+	 */
+#if defined(EVE_ESP32_STATS)
+	eve_lock(pb.lcd);
+	eve_esp32_stats(pb.lcd, &before);
+	start = esp_timer_get_time();
+
+	if (eve_write(pb.lcd, PB_SNAP_STAGING, dl.buf, dl.len * 4) < 0) {
+		eve_unlock(pb.lcd);
+		printf("write failed\n");
+		return 1;
+	}
+
+	us = esp_timer_get_time() - start;
+	eve_esp32_stats(pb.lcd, &after);
+	eve_unlock(pb.lcd);
+
+	printf("            %llu bytes in %lu transactions, %lld us on the bus\n",
+	    (unsigned long long)(after.bytes_written - before.bytes_written),
+	    (unsigned long)(after.transactions - before.transactions),
+	    (long long)us);
+#else
+	printf("            %lu bytes, statistics not compiled in, see PB_EVE_STATS\n",
+	    (unsigned long)dl.len * 4);
+#endif
+	printf("cmd_text:   %lu bytes to the FIFO\n", (unsigned long)cp_bytes);
+
+	return 0;
+}
+
+static int
+cmd_eve_idle(void)
+{
+	static const char *states[EVE_IDLE_NSTATES] = {
+		"active", "dim", "standby", "sleep", "waking"
+	};
+	struct eve_idle_stats st;
+
+	eve_idle_stats(&pb.idle, &st, esp_timer_get_time());
+
+	printf("state: %s\n", states[pb.idle.state]);
+
+	for (int i = 0; i < EVE_IDLE_NSTATES; ++i)
+		printf("  %-8s %6lu times, %lld ms\n",
+		    states[i], (unsigned long)st.entered[i], (long long)st.time_us[i] / 1000);
+
+	printf("wakes:    %lu\n", (unsigned long)st.wakes);
+	printf("wake:     %lld us last, %lld us max, %lld us avg\n",
+	    (long long)st.wake_last_us,
+	    (long long)st.wake_max_us,
+	    (long long)(st.wakes ? st.wake_sum_us / st.wakes : 0));
+	printf("errors:   %lu\n", (unsigned long)st.errors);
+
+	return 0;
+}
+
+static int
+cmd_eve_run(int argc, char **argv)
+{
+	if (argc >= 2 && strcmp(argv[1], "frames") == 0) {
+		const struct eve_frame_stats *st = &pb.frame.stats;
+
+		printf("rendered:   %lu\n", (unsigned long)st->rendered);
+		printf("shown:      %lu\n", (unsigned long)st->shown);
+		printf("late:       %lu\n", (unsigned long)st->late);
+		printf("dropped:    %lu\n", (unsigned long)st->dropped);
+		printf("errors:     %lu\n", (unsigned long)st->errors);
+		printf("jitter max: %lld us\n", (long long)st->jitter_max_us);
+		printf("jitter avg: %lld us\n",
+		    (long long)(st->shown > 1 ? st->jitter_sum_us / (st->shown - 1) : 0));
+		printf("dl bytes:   %llu sent, %llu full\n",
+		    (unsigned long long)pb.frame.shadow.bytes_sent,
+		    (unsigned long long)pb.frame.shadow.bytes_full);
+
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "touch") == 0) {
+		printf("samples: %lu\n", (unsigned long)pb.touch.samples);
+		printf("dropped: %lu\n", (unsigned long)pb.touch.dropped);
+
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "snap") == 0)
+		return cmd_eve_snap(argc, argv);
+
+	if (argc >= 2 && strcmp(argv[1], "text") == 0)
+		return cmd_eve_text();
+
+	if (argc >= 2 && strcmp(argv[1], "scene") == 0) {
+		const struct eve_scene_stats *st = &pb.scene.stats;
+
+		printf("encoded:     %lu\n", (unsigned long)st->encoded);
+		printf("patched:     %lu\n", (unsigned long)st->patched);
+		printf("rebuilds:    %lu\n", (unsigned long)st->rebuilds);
+		printf("merged:      %lu\n", (unsigned long)st->merged);
+		printf("compactions: %lu\n", (unsigned long)st->compactions);
+		printf("words:       %lu\n", (unsigned long)pb.scene.list_len);
+
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "beep") == 0) {
+		atomic_store(&pb.beep, 1);
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "audio") == 0) {
+		const struct eve_audio_stats *st = &pb.audio.stats;
+
+		printf("refills:   %lu\n", (unsigned long)st->refills);
+		printf("underruns: %lu\n", (unsigned long)st->underruns);
+		printf("errors:    %lu\n", (unsigned long)st->errors);
+		printf("bytes:     %llu\n", (unsigned long long)st->bytes);
+
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "flash") == 0) {
+		static const char *states[] = { "init", "detached", "basic", "full" };
+		uint8_t status = 0;
+
+		eve_read8(pb.lcd, EVE_REG_FLASH_STATUS, &status);
+		printf("status: %s\n", states[status & 3]);
+		printf("fast:   0x%04lx\n", (unsigned long)pb.flash_result);
+
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "shadow") == 0) {
+		struct eve_shadow_stats st;
+
+		if (argc >= 3 && strcmp(argv[2], "reset") == 0) {
+			eve_shadow_stats_reset(pb.lcd);
+			return 0;
+		}
+
+		eve_shadow_stats(pb.lcd, &st);
+		printf("hits:   %lu\n", (unsigned long)st.hits);
+		printf("misses: %lu\n", (unsigned long)st.misses);
+		printf("elided: %lu\n", (unsigned long)st.elided);
+
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "stats") == 0) {
+#if defined(EVE_ESP32_STATS)
+		if (argc >= 3 && strcmp(argv[2], "reset") == 0)
+			eve_esp32_stats_reset(pb.lcd);
+		else
+			cmd_eve_stats();
+
+		return 0;
+#else
+		printf("statistics not compiled in, see PB_EVE_STATS\n");
+		return 1;
+#endif
+	}
+
+	printf("usage: eve frames | touch | snap [dump | crc] | scene | text | beep | audio\n"
+	       "           | flash | idle | wake | shadow [reset] | stats [reset]\n");
+
+	return 1;
+}
+
+/*
+ * Commands accessing the device count as activity: the LCD task is asked to
+ * wake it up and to keep it awake until the command is done.
+ */
+static int
+cmd_eve(int argc, char **argv)
+{
+	int64_t deadline;
+	int rc;
+
+	if (!pb.lcd_ready) {
+		printf("LCD unavailable\n");
+		return 1;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "wake") == 0) {
+		atomic_store(&pb.wake, 1);
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "idle") == 0)
+		return cmd_eve_idle();
+
+	/* A held flag left from a previous command doesn't count. */
+	atomic_store(&pb.held, 0);
+	atomic_store(&pb.busy, 1);
+
+	deadline = esp_timer_get_time() + PB_IDLE_HOLD_MS * 1000LL;
+
+	while (!atomic_load(&pb.held) || !atomic_load(&pb.awake)) {
+		if (esp_timer_get_time() >= deadline) {
+			atomic_store(&pb.busy, 0);
+			printf("LCD not waking up, see 'eve idle'\n");
+			return 1;
+		}
+
+		vTaskDelay(1);
+	}
+
+	rc = cmd_eve_run(argc, argv);
+	atomic_store(&pb.busy, 0);
+
+	return rc;
+}
+
+static void
+init_console(void)
+{
+	esp_err_t err;
+	esp_console_repl_t *repl = NULL;
+	esp_console_repl_config_t repl_cfg = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+	esp_console_dev_uart_config_t uart_cfg = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+	const esp_console_cmd_t cmd = {
+		.command = "eve",
+		.help    = "EVE controller, 'eve frames' shows the frame scheduler, "
+		           "'eve touch' touch input, 'eve snap [dump | crc]' screen capture, "
+		           "'eve beep' plays a tone, 'eve scene' scene statistics, "
+		           "'eve text' text rendering costs, "
+		           "'eve audio' audio streaming, 'eve flash' flash status, "
+		           "'eve idle' power states, 'eve wake' leaves them, "
+		           "'eve shadow [reset]' register shadow, "
+		           "'eve stats [reset]' SPI bus usage",
+		.func    = cmd_eve,
+	};
+
+	repl_cfg.prompt = PB_CONSOLE_PROMPT;
+
+	ESP_LOGI(TAG, "initializing console");
+	err = esp_console_new_repl_uart(&uart_cfg, &repl_cfg, &repl);
+	ESP_ERROR_CHECK(err);
+
+	esp_console_register_help_command();
+	err = esp_console_cmd_register(&cmd);
+	ESP_ERROR_CHECK(err);
+
+	err = esp_console_start_repl(repl);
+	ESP_ERROR_CHECK(err);
 }
 
 void
@@ -167,6 +910,7 @@ app_main(void)
 	init_logs();
 	init_spi();
 	init_lcd();
+	init_console();
 
 	for (;;) {
 		vTaskDelay(pdMS_TO_TICKS(1000));
@@ -5,8 +5,12 @@
 
 #define PB_SCONF_PIN_CS         GPIO_NUM_@PB_PIN_CS@
 #define PB_SCONF_PIN_PD         GPIO_NUM_@PB_PIN_PD@
+#define PB_SCONF_PIN_INT        GPIO_NUM_@PB_PIN_INT@
 #define PB_SCONF_PIN_MOSI       GPIO_NUM_@PB_PIN_MOSI@
 #define PB_SCONF_PIN_MISO       GPIO_NUM_@PB_PIN_MISO@
 #define PB_SCONF_PIN_SCLK       GPIO_NUM_@PB_PIN_SCLK@
+#define PB_SCONF_PIN_IO2        GPIO_NUM_@PB_PIN_IO2@
+#define PB_SCONF_PIN_IO3        GPIO_NUM_@PB_PIN_IO3@
+#define PB_SCONF_SPI_WIDTH      @PB_SPI_WIDTH@
 
 #endif /* !PB_SYSCONFIG_H */
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+#
+# eveflash.py -- build a BT816 external flash image for main/eve_flash.c
+#
+# Usage: eveflash.py -b blob.bin [-s size] [-H assets.h] -o flash.bin file...
+#
+# The BRT blob (unified.blob from the EVE Asset Builder) goes in the first
+# sector, it is needed by CMD_FLASHFAST. Files follow from the second sector,
+# each one aligned to 64 bytes. ASTC files (.astc, as written by astcenc)
+# lose their 16 bytes header and are drawn directly from flash with
+# eve_flash_astc(), anything else is stored as is and can be copied into
+# RAM_G with CMD_FLASHREAD.
+#
+# The header given with -H has the address and size of every file, plus the
+# format and dimensions of ASTC images:
+#
+#   eve_flash_astc(dl, 0, FLASH_LOGO_ADDR, FLASH_LOGO_FORMAT,
+#                  FLASH_LOGO_WIDTH, FLASH_LOGO_HEIGHT);
+#
+# The image can be programmed with eve_flash_program() or any flash writer.
+#
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SECTOR = 4096
+BLOB_SIZE = 4096
+ALIGN = 64
+
+ASTC_MAGIC = 0x5CA1AB13
+ASTC_HEADER = struct.Struct("<I3B3s3s3s")
+
+ASTC_BLOCKS = [
+    (4, 4), (5, 4), (5, 5), (6, 5), (6, 6),
+    (8, 5), (8, 6), (8, 8), (10, 5), (10, 6),
+    (10, 8), (10, 10), (12, 10), (12, 12),
+]
+
+
+def align(value, n=ALIGN):
+    return (value + n - 1) & ~(n - 1)
+
+
+def u24(b):
+    return b[0] | b[1] << 8 | b[2] << 16
+
+
+def load(path):
+    with open(path, "rb") as fp:
+        data = fp.read()
+
+    if os.path.splitext(path)[1].lower() != ".astc":
+        return data, None
+
+    if len(data) < ASTC_HEADER.size:
+        sys.exit("eveflash: {}: truncated ASTC header".format(path))
+
+    magic, bw, bh, bd, xs, ys, zs = ASTC_HEADER.unpack_from(data)
+
+    if magic != ASTC_MAGIC:
+        sys.exit("eveflash: {}: not an ASTC file".format(path))
+    if bd != 1 or u24(zs) != 1:
+        sys.exit("eveflash: {}: 3D textures are not supported".format(path))
+    if (bw, bh) not in ASTC_BLOCKS:
+        sys.exit("eveflash: {}: unsupported block size {}x{}".format(path, bw, bh))
+
+    return data[ASTC_HEADER.size:], (bw, bh, u24(xs), u24(ys))
+
+
+def symbol(path):
+    name = os.path.splitext(os.path.basename(path))[0]
+
+    return "FLASH_" + re.sub(r"[^0-9A-Za-z]", "_", name).upper()
+
+
+def manifest(assets):
+    lines = [
+        "/* Generated by tools/eveflash.py, do not edit. */",
+        "",
+        "#ifndef EVEFLASH_ASSETS_H",
+        "#define EVEFLASH_ASSETS_H",
+        "",
+    ]
+
+    for path, address, data, astc in assets:
+        sym = symbol(path)
+        lines.append("#define {:<32} 0x{:08x}U".format(sym + "_ADDR", address))
+        lines.append("#define {:<32} {}U".format(sym + "_SIZE", len(data)))
+
+        if astc:
+            bw, bh, width, height = astc
+            lines.append("#define {:<32} EVE_FORMAT_ASTC_{}X{}".format(sym + "_FORMAT", bw, bh))
+            lines.append("#define {:<32} {}".format(sym + "_WIDTH", width))
+            lines.append("#define {:<32} {}".format(sym + "_HEIGHT", height))
+
+        lines.append("")
+
+    lines.append("#endif /* !EVEFLASH_ASSETS_H */")
+
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="build an EVE flash image")
+    parser.add_argument("-o", "--output", required=True, help="output image")
+    parser.add_argument("-b", "--blob", required=True, help="BRT flash blob")
+    parser.add_argument("-s", "--size", type=lambda v: int(v, 0), help="pad image to flash size")
+    parser.add_argument("-H", "--header", help="write addresses to a C header")
+    parser.add_argument("files", nargs="*")
+    args = parser.parse_args()
+
+    with open(args.blob, "rb") as fp:
+        blob = fp.read()
+
+    if len(blob) != BLOB_SIZE:
+        sys.exit("eveflash: {}: blob is {} bytes, expected {}".format(args.blob, len(blob), BLOB_SIZE))
+
+    image = bytearray(blob)
+    assets = []
+    symbols = set()
+
+    for path in args.files:
+        if symbol(path) in symbols:
+            sys.exit("eveflash: {}: duplicate name".format(path))
+
+        symbols.add(symbol(path))
+        data, astc = load(path)
+        address = align(len(image))
+
+        image += b"\xff" * (address - len(image)) + data
+        assets.append((path, address, data, astc))
+
+    # CMD_FLASHUPDATE works on whole sectors.
+    image += b"\xff" * (align(len(image), SECTOR) - len(image))
+
+    if args.size is not None:
+        if len(image) > args.size:
+            sys.exit("eveflash: image is {} bytes, flash is {}".format(len(image), args.size))
+
+        image += b"\xff" * (args.size - len(image))
+
+    with open(args.output, "wb") as fp:
+        fp.write(image)
+
+    if args.header:
+        with open(args.header, "w") as fp:
+            fp.write(manifest(assets))
+
+    for path, address, data, astc in assets:
+        kind = "astc {}x{} {}x{}".format(*astc) if astc else "raw"
+        print("{:<24} 0x{:06x} {:>8} ({})".format(os.path.basename(path), address, len(data), kind))
+
+
+if __name__ == "__main__":
+    main()
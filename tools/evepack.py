@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+#
+# evepack.py -- build an asset partition image for main/eve_asset.c
+#
+# Usage: evepack.py [-s size] [-r] -o assets.bin file...
+#
+# PNG and JPEG files are stored as is and decoded on the device by
+# CMD_LOADIMAGE, everything else is zlib compressed for CMD_INFLATE unless
+# -r is given. The raw size of an entry is what it takes in RAM_G once
+# loaded, for images at most 2 bytes per pixel or the indices and palette.
+# The image can be written to the assets partition of partitions.csv (4MB,
+# -s 0x400000 checks it fits) with:
+#
+#   parttool.py write_partition --partition-name assets --input assets.bin
+#
+# An image named logo.png is loaded into RAM_G at boot by main.c.
+#
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = b"EVEA"
+VERSION = 1
+NAME_MAX = 24
+
+TYPE_RAW = 0
+TYPE_DEFLATE = 1
+TYPE_IMAGE = 2
+
+HEADER = struct.Struct("<4sII")
+ENTRY = struct.Struct("<%dsIIII" % NAME_MAX)
+
+
+def align(value, n=4):
+    return (value + n - 1) & ~(n - 1)
+
+
+def png_size(path, data):
+    if data[:8] != b"\x89PNG\r\n\x1a\n" or data[12:16] != b"IHDR":
+        sys.exit("evepack: {}: not a PNG file".format(path))
+
+    width, height = struct.unpack(">II", data[16:24])
+
+    # Paletted images get their palette after the indices.
+    if data[25] == 3:
+        return width * height + 1024
+
+    return width * height * 2
+
+
+def jpeg_size(path, data):
+    pos = 2
+
+    # Walk the segments up to the start of frame holding the dimensions.
+    while data[:2] == b"\xff\xd8" and pos + 9 <= len(data) and data[pos] == 0xff:
+        marker = data[pos + 1]
+        length = struct.unpack(">H", data[pos + 2:pos + 4])[0]
+
+        if 0xc0 <= marker <= 0xcf and marker not in (0xc4, 0xc8, 0xcc):
+            height, width = struct.unpack(">HH", data[pos + 5:pos + 9])
+            return width * height * 2
+
+        pos += 2 + length
+
+    sys.exit("evepack: {}: not a JPEG file".format(path))
+
+
+def load(path, raw):
+    with open(path, "rb") as fp:
+        data = fp.read()
+
+    ext = os.path.splitext(path)[1].lower()
+
+    if ext == ".png":
+        return TYPE_IMAGE, data, png_size(path, data)
+    if ext in (".jpg", ".jpeg"):
+        return TYPE_IMAGE, data, jpeg_size(path, data)
+    if raw:
+        return TYPE_RAW, data, len(data)
+
+    return TYPE_DEFLATE, zlib.compress(data, 9), len(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="build an EVE asset partition")
+    parser.add_argument("-o", "--output", required=True, help="output image")
+    parser.add_argument("-s", "--size", type=lambda v: int(v, 0), help="pad image to partition size")
+    parser.add_argument("-r", "--raw", action="store_true", help="do not compress non image files")
+    parser.add_argument("files", nargs="+")
+    args = parser.parse_args()
+
+    assets = []
+
+    for path in args.files:
+        name = os.path.basename(path).encode()
+
+        if len(name) > NAME_MAX:
+            sys.exit("evepack: {}: name longer than {} bytes".format(path, NAME_MAX))
+
+        kind, data, raw_size = load(path, args.raw)
+        assets.append((name, kind, data, raw_size))
+
+    offset = align(HEADER.size + ENTRY.size * len(assets))
+    index = HEADER.pack(MAGIC, VERSION, len(assets))
+    blob = b""
+
+    for name, kind, data, raw_size in assets:
+        index += ENTRY.pack(name, offset + len(blob), len(data), raw_size, kind)
+        blob += data + b"\0" * (align(len(data)) - len(data))
+
+    image = index + b"\0" * (align(len(index)) - len(index)) + blob
+
+    if args.size is not None:
+        if len(image) > args.size:
+            sys.exit("evepack: image is {} bytes, partition is {}".format(len(image), args.size))
+
+        image += b"\xff" * (args.size - len(image))
+
+    with open(args.output, "wb") as fp:
+        fp.write(image)
+
+    for name, kind, data, raw_size in assets:
+        print("{:<24} {:>8} -> {:>8} ({})".format(
+            name.decode(), raw_size, len(data), ("raw", "deflate", "image")[kind]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+#
+# evesnap.py -- turn an 'eve snap dump' console log into an image
+#
+# Usage: evesnap.py [-o snap.ppm] [-r snap.bin] [-g golden.bin] console.log
+#
+# The raw RGB565 capture written with -r can serve as golden image later
+# on, -g compares the capture with it and exits with status 1 when they
+# differ, reporting the bounding box of the differing pixels.
+#
+
+import argparse
+import struct
+import sys
+import zlib
+
+
+def parse(path):
+    width = height = crc = None
+    chunks = {}
+
+    with open(path, "r", errors="replace") as fp:
+        for line in fp:
+            fields = line.split()
+
+            if len(fields) < 2 or fields[0] != "snap":
+                continue
+            if len(fields) == 4 and fields[3] == "rgb565":
+                width, height = int(fields[1]), int(fields[2])
+                chunks = {}
+            elif fields[1] == "crc":
+                crc = int(fields[2], 16)
+            elif len(fields) == 3:
+                chunks[int(fields[1], 16)] = bytes.fromhex(fields[2])
+
+    if width is None:
+        sys.exit("evesnap: {}: no capture found".format(path))
+
+    data = bytearray()
+
+    for offset in sorted(chunks):
+        if offset != len(data):
+            sys.exit("evesnap: {}: missing data at 0x{:x}".format(path, offset))
+
+        data += chunks[offset]
+
+    if len(data) != width * height * 2:
+        sys.exit("evesnap: {}: {} bytes, expected {}".format(path, len(data), width * height * 2))
+    if crc is not None and zlib.crc32(data) != crc:
+        sys.exit("evesnap: {}: CRC mismatch".format(path))
+
+    return width, height, bytes(data)
+
+
+def ppm(width, height, data):
+    out = bytearray(b"P6\n%d %d\n255\n" % (width, height))
+
+    for (pixel,) in struct.iter_unpack("<H", data):
+        r, g, b = pixel >> 11, pixel >> 5 & 0x3f, pixel & 0x1f
+        out += bytes((r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2))
+
+    return out
+
+
+def compare(width, data, golden):
+    box = None
+    pixels = 0
+
+    for i in range(0, len(data), 2):
+        if data[i:i + 2] == golden[i:i + 2]:
+            continue
+
+        x, y = i // 2 % width, i // 2 // width
+        pixels += 1
+
+        if box is None:
+            box = [x, y, x, y]
+        else:
+            box = [min(box[0], x), box[1], max(box[2], x), y]
+
+    return pixels, box
+
+
+def main():
+    parser = argparse.ArgumentParser(description="convert an EVE screen capture")
+    parser.add_argument("-o", "--output", help="write a PPM image")
+    parser.add_argument("-r", "--raw", help="write the raw RGB565 capture")
+    parser.add_argument("-g", "--golden", help="compare with a raw RGB565 capture")
+    parser.add_argument("log")
+    args = parser.parse_args()
+
+    width, height, data = parse(args.log)
+    print("{}x{} crc {:08x}".format(width, height, zlib.crc32(data)))
+
+    if args.output:
+        with open(args.output, "wb") as fp:
+            fp.write(ppm(width, height, data))
+
+    if args.raw:
+        with open(args.raw, "wb") as fp:
+            fp.write(data)
+
+    if args.golden:
+        with open(args.golden, "rb") as fp:
+            golden = fp.read()
+
+        if len(golden) != len(data):
+            sys.exit("evesnap: {}: size differs".format(args.golden))
+
+        pixels, box = compare(width, data, golden)
+
+        if pixels:
+            print("{} pixels differ in {},{}-{},{} (golden crc {:08x})".format(
+                pixels, *box, zlib.crc32(golden)))
+            sys.exit(1)
+
+        print("identical to golden")
+
+
+if __name__ == "__main__":
+    main()